@@ -0,0 +1,365 @@
+// Compares fmt against std::format (when the standard library has it),
+// snprintf and std::ostringstream on a fixed set of workloads, reporting the
+// time, bytes allocated and allocations per call.
+//
+//   format_bench [filter]
+//
+// runs every workload whose name contains `filter`.
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+#if __has_include(<print>)
+#include <print>
+#endif
+
+#include "format/compile.hpp"
+#include "format/format.hpp"
+#include "format/print.hpp"
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+std::atomic<std::size_t> allocated_bytes{0};
+
+}  // namespace
+
+// Every allocation in the process goes through here, so each call can be
+// charged with what it allocated.
+auto operator new(const std::size_t size) -> void* {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (void* const ptr{std::malloc(size == 0 ? 1 : size)}) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+auto operator delete(void* const ptr) noexcept -> void { std::free(ptr); }
+auto operator delete(void* const ptr, std::size_t) noexcept -> void {
+  std::free(ptr);
+}
+
+namespace {
+
+struct Point {
+  int x;
+  int y;
+};
+
+auto operator<<(std::ostream& out, const Point& point) -> std::ostream& {
+  return out << '(' << point.x << ", " << point.y << ')';
+}
+
+}  // namespace
+
+namespace fmt {
+template <>
+struct Formatter<Point> {
+  static constexpr auto buf_print(Buffer& str, const Point& val,
+                                  const FormatSpecifier& specifier) -> void {
+    str.push_back('(');
+    fmt::buf_print(str, val.x, specifier);
+    str.append(", ");
+    fmt::buf_print(str, val.y, specifier);
+    str.push_back(')');
+  }
+};
+}  // namespace fmt
+
+#if defined(__cpp_lib_format)
+template <>
+struct std::formatter<Point> : std::formatter<int> {
+  auto format(const Point& point, std::format_context& ctx) const {
+    auto out{ctx.out()};
+    *out++ = '(';
+    out = std::formatter<int>::format(point.x, ctx);
+    *out++ = ',';
+    *out++ = ' ';
+    ctx.advance_to(out);
+    out = std::formatter<int>::format(point.y, ctx);
+    *out++ = ')';
+    return out;
+  }
+};
+#endif
+
+namespace {
+
+/// @brief Keeps the compiler from discarding a result it can see is unused.
+template <typename Type>
+auto keep(const Type& value) -> void {
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static const void* volatile sink{};
+  sink = &value;
+#endif
+}
+
+/// @brief A stream that throws everything away, to time formatting rather
+/// than I/O.
+class NullBuffer : public std::streambuf {
+ protected:
+  auto overflow(const int_type c) -> int_type override { return c; }
+  auto xsputn(const char*, const std::streamsize count)
+      -> std::streamsize override {
+    return count;
+  }
+};
+
+struct Result {
+  double ns_;
+  double bytes_;
+  double allocations_;
+};
+
+/// @brief Runs `body` in doubling batches until one takes long enough to
+/// time, then reports the per-call cost of that batch.
+template <typename Body>
+auto measure(Body body) -> Result {
+  using Clock = std::chrono::steady_clock;
+  constexpr std::chrono::milliseconds MinTime{100};
+
+  for (int i = 0; i < 100; ++i) {
+    keep(body());
+  }
+  for (std::size_t iterations = 1000;; iterations *= 2) {
+    const auto calls{allocations.load(std::memory_order_relaxed)};
+    const auto bytes{allocated_bytes.load(std::memory_order_relaxed)};
+    const auto begin{Clock::now()};
+    for (std::size_t i = 0; i < iterations; ++i) {
+      keep(body());
+    }
+    const auto elapsed{Clock::now() - begin};
+    if (elapsed >= MinTime) {
+      const auto count{static_cast<double>(iterations)};
+      return Result{
+          std::chrono::duration<double, std::nano>{elapsed}.count() / count,
+          static_cast<double>(
+              allocated_bytes.load(std::memory_order_relaxed) - bytes) /
+              count,
+          static_cast<double>(allocations.load(std::memory_order_relaxed) -
+                              calls) /
+              count,
+      };
+    }
+  }
+}
+
+class Suite {
+ public:
+  explicit Suite(const std::string_view filter) : filter_{filter} {
+    std::printf("%-14s %-16s %10s %10s %10s\n", "workload", "library",
+                "ns/op", "B/op", "allocs/op");
+  }
+
+  template <typename Body>
+  auto run(const std::string_view workload, const std::string_view library,
+           Body body) -> void {
+    if (workload.find(filter_) == std::string_view::npos) {
+      return;
+    }
+    const auto result{measure(body)};
+    std::printf("%-14.*s %-16.*s %10.1f %10.1f %10.2f\n",
+                static_cast<int>(workload.size()), workload.data(),
+                static_cast<int>(library.size()), library.data(), result.ns_,
+                result.bytes_, result.allocations_);
+  }
+
+ private:
+  std::string_view filter_;
+};
+
+/// @brief snprintf into a stack buffer, then into a string, which is what
+/// the other libraries return.
+template <typename... Args>
+auto sprintf_string(const char* const fmt, const Args&... args)
+    -> std::string {
+  char buf[2048];
+  const auto size{std::snprintf(buf, sizeof(buf), fmt, args...)};
+  return std::string(buf, static_cast<std::size_t>(size));
+}
+
+template <typename... Args>
+auto stream_string(const Args&... args) -> std::string {
+  std::ostringstream out{};
+  (out << ... << args);
+  return std::move(out).str();
+}
+
+auto bench_values(Suite& suite) -> void {
+  suite.run("small int", "fmt::format", [] { return fmt::format("{}", 42); });
+  suite.run("small int", "fmt::compile",
+            [] { return fmt::format(fmt::compile<"{}">, 42); });
+#if defined(__cpp_lib_format)
+  suite.run("small int", "std::format", [] { return std::format("{}", 42); });
+#endif
+  suite.run("small int", "snprintf", [] { return sprintf_string("%d", 42); });
+  suite.run("small int", "ostringstream", [] { return stream_string(42); });
+
+  static constexpr std::uint64_t Hex{0x0123456789ABCDEFULL};
+  suite.run("hex u64", "fmt::format", [] { return fmt::format("{:x}", Hex); });
+  suite.run("hex u64", "fmt::compile",
+            [] { return fmt::format(fmt::compile<"{:x}">, Hex); });
+#if defined(__cpp_lib_format)
+  suite.run("hex u64", "std::format", [] { return std::format("{:x}", Hex); });
+#endif
+  suite.run("hex u64", "snprintf",
+            [] { return sprintf_string("%" PRIx64, Hex); });
+  suite.run("hex u64", "ostringstream",
+            [] { return stream_string(std::hex, Hex); });
+
+  static constexpr double Float{3.14159265358979};
+  suite.run("double", "fmt::format",
+            [] { return fmt::format("{:.3f}", Float); });
+#if defined(__cpp_lib_format)
+  suite.run("double", "std::format",
+            [] { return std::format("{:.3f}", Float); });
+#endif
+  suite.run("double", "snprintf", [] { return sprintf_string("%.3f", Float); });
+  suite.run("double", "ostringstream", [] {
+    return stream_string(std::fixed, std::setprecision(3), Float);
+  });
+
+  const char* const Short{"hello"};
+  suite.run("short string", "fmt::format",
+            [&] { return fmt::format("{}", Short); });
+#if defined(__cpp_lib_format)
+  suite.run("short string", "std::format",
+            [&] { return std::format("{}", Short); });
+#endif
+  suite.run("short string", "snprintf",
+            [&] { return sprintf_string("%s", Short); });
+  suite.run("short string", "ostringstream",
+            [&] { return stream_string(Short); });
+
+  const std::string Long(1000, 'x');
+  suite.run("long string", "fmt::format",
+            [&] { return fmt::format("{}", Long); });
+#if defined(__cpp_lib_format)
+  suite.run("long string", "std::format",
+            [&] { return std::format("{}", Long); });
+#endif
+  suite.run("long string", "snprintf",
+            [&] { return sprintf_string("%s", Long.c_str()); });
+  suite.run("long string", "ostringstream",
+            [&] { return stream_string(Long); });
+
+  const Point point{12, -34};
+  suite.run("Point", "fmt::format", [&] { return fmt::format("{}", point); });
+#if defined(__cpp_lib_format)
+  suite.run("Point", "std::format", [&] { return std::format("{}", point); });
+#endif
+  suite.run("Point", "snprintf",
+            [&] { return sprintf_string("(%d, %d)", point.x, point.y); });
+  suite.run("Point", "ostringstream", [&] { return stream_string(point); });
+}
+
+auto bench_lines(Suite& suite) -> void {
+  const std::string user{"alice"};
+  suite.run("1 arg line", "fmt::format",
+            [&] { return fmt::format("user {} logged in", user); });
+#if defined(__cpp_lib_format)
+  suite.run("1 arg line", "std::format",
+            [&] { return std::format("user {} logged in", user); });
+#endif
+  suite.run("1 arg line", "snprintf",
+            [&] { return sprintf_string("user %s logged in", user.c_str()); });
+  suite.run("1 arg line", "ostringstream",
+            [&] { return stream_string("user ", user, " logged in"); });
+
+  suite.run("5 arg line", "fmt::format", [&] {
+    return fmt::format("{} {}: {} items, {:.2f} ms, id {:x}", "GET", user, 17,
+                       2.5, 0xBEEFU);
+  });
+#if defined(__cpp_lib_format)
+  suite.run("5 arg line", "std::format", [&] {
+    return std::format("{} {}: {} items, {:.2f} ms, id {:x}", "GET", user, 17,
+                       2.5, 0xBEEFU);
+  });
+#endif
+  suite.run("5 arg line", "snprintf", [&] {
+    return sprintf_string("%s %s: %d items, %.2f ms, id %x", "GET",
+                          user.c_str(), 17, 2.5, 0xBEEFU);
+  });
+  suite.run("5 arg line", "ostringstream", [&] {
+    return stream_string("GET ", user, ": ", 17, " items, ", std::fixed,
+                         std::setprecision(2), 2.5, " ms, id ", std::hex,
+                         0xBEEFU);
+  });
+
+  suite.run("10 arg line", "fmt::format", [&] {
+    return fmt::format("{} {} {} {} {} | {} {} {} {} {}", 1, "two", 3.5, user,
+                       -5, 6U, "seven", 8, 9.25, 10);
+  });
+#if defined(__cpp_lib_format)
+  suite.run("10 arg line", "std::format", [&] {
+    return std::format("{} {} {} {} {} | {} {} {} {} {}", 1, "two", 3.5, user,
+                       -5, 6U, "seven", 8, 9.25, 10);
+  });
+#endif
+  suite.run("10 arg line", "snprintf", [&] {
+    return sprintf_string("%d %s %g %s %d | %u %s %d %g %d", 1, "two", 3.5,
+                          user.c_str(), -5, 6U, "seven", 8, 9.25, 10);
+  });
+  suite.run("10 arg line", "ostringstream", [&] {
+    return stream_string(1, ' ', "two", ' ', 3.5, ' ', user, ' ', -5, " | ",
+                         6U, ' ', "seven", ' ', 8, ' ', 9.25, ' ', 10);
+  });
+}
+
+auto bench_print(Suite& suite) -> void {
+  NullBuffer null_buffer{};
+  std::ostream null_stream{&null_buffer};
+  std::FILE* const null_file{std::fopen("/dev/null", "w")};
+
+  suite.run("print", "fmt::print", [&] {
+    fmt::print(null_stream, "{} {}: {}\n", "GET", "/index.html", 200);
+    return 0;
+  });
+#if defined(__cpp_lib_print)
+  suite.run("print", "std::print", [&] {
+    std::print(null_stream, "{} {}: {}\n", "GET", "/index.html", 200);
+    return 0;
+  });
+#endif
+  if (null_file not_eq nullptr) {
+    suite.run("print", "fmt::print FILE", [&] {
+      fmt::print(null_file, "{} {}: {}\n", "GET", "/index.html", 200);
+      return 0;
+    });
+    suite.run("print", "fprintf", [&] {
+      std::fprintf(null_file, "%s %s: %d\n", "GET", "/index.html", 200);
+      return 0;
+    });
+    std::fclose(null_file);
+  }
+  suite.run("print", "ostream", [&] {
+    null_stream << "GET" << ' ' << "/index.html" << ": " << 200 << '\n';
+    return 0;
+  });
+}
+
+}  // namespace
+
+auto main(const int argc, char** argv) -> int {
+  Suite suite{argc > 1 ? argv[1] : ""};
+  bench_values(suite);
+  bench_lines(suite);
+  bench_print(suite);
+}
@@ -0,0 +1,100 @@
+# Compile-time benchmark: generates a translation unit with SITES distinct
+# format and print call sites, compiles it header-only and against
+# format_core, and reports the build time, object size and bytes per site.
+#
+#   cmake -DCOMPILER=g++ -DINCLUDE_DIR=include -DOUTPUT_DIR=/tmp/cb \
+#         [-DSITES=2000] [-DFLAGS="-std=c++23 -O2"] -P compile_bench.cmake
+#
+# Every site has its own format string and cycles through argument counts
+# 0 to 4 and a mix of argument types, so each one is a distinct
+# instantiation of the argument checks and the formatting code.
+
+foreach(required COMPILER INCLUDE_DIR OUTPUT_DIR)
+  if(NOT DEFINED ${required})
+    message(FATAL_ERROR "compile_bench: ${required} is not set")
+  endif()
+endforeach()
+if(NOT DEFINED SITES)
+  set(SITES 2000)
+endif()
+if(NOT DEFINED FLAGS)
+  set(FLAGS "-std=c++23 -O2")
+endif()
+
+# int, unsigned, i64, double, const char*, string_view, char, std::string.
+set(values "1" "2u" "fmt::i64{3}" "4.5" "\"five\""
+    "std::string_view{\"six\"}" "'7'" "std::string{\"eight\"}")
+list(LENGTH values type_count)
+
+set(source "#include <cstdio>\n#include <string>\n#include <string_view>\n\n")
+string(APPEND source "#include \"format/format.hpp\"\n")
+string(APPEND source "#include \"format/print.hpp\"\n\n")
+string(APPEND source
+    "auto run_sites(std::string& out, std::FILE* file) -> void {\n")
+
+math(EXPR last "${SITES} - 1")
+foreach(site RANGE ${last})
+  math(EXPR arity "${site} % 5")
+  set(fields "")
+  set(args "")
+  if(arity GREATER 0)
+    math(EXPR last_arg "${arity} - 1")
+    foreach(arg RANGE ${last_arg})
+      math(EXPR type "(${site} / 5 + ${arg} * 3) % ${type_count}")
+      list(GET values ${type} value)
+      string(APPEND fields " {}")
+      string(APPEND args ", ${value}")
+    endforeach()
+  endif()
+  # Every other group of five sites prints instead of formatting.
+  math(EXPR prints "(${site} / 5) % 2")
+  if(prints)
+    string(APPEND source
+        "  fmt::print(file, \"site ${site}:${fields}\\n\"${args});\n")
+  else()
+    string(APPEND source
+        "  out += fmt::format(\"site ${site}:${fields}\\n\"${args});\n")
+  endif()
+endforeach()
+string(APPEND source "}\n")
+
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+set(source_file "${OUTPUT_DIR}/compile_bench_sites.cc")
+file(WRITE "${source_file}" "${source}")
+separate_arguments(flag_list NATIVE_COMMAND "${FLAGS}")
+
+message(STATUS "compile_bench: ${SITES} call sites, flags ${FLAGS}")
+
+# Compiles the sites once per variant and reports the build time and object
+# size; `defines` are extra compiler arguments.
+function(measure name defines)
+  set(object_file "${OUTPUT_DIR}/compile_bench_${name}.o")
+  string(TIMESTAMP start "%s%f")
+  execute_process(
+      COMMAND "${COMPILER}" ${flag_list} ${defines} "-I${INCLUDE_DIR}"
+              -c "${source_file}" -o "${object_file}"
+      RESULT_VARIABLE result
+      ERROR_VARIABLE errors)
+  string(TIMESTAMP finish "%s%f")
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "compile_bench: compilation failed\n${errors}")
+  endif()
+
+  # %s%f is microseconds since the epoch.
+  math(EXPR elapsed_ms "(${finish} - ${start}) / 1000")
+  math(EXPR per_site_us "(${finish} - ${start}) / ${SITES}")
+  file(SIZE "${object_file}" object_size)
+  math(EXPR object_kib "${object_size} / 1024")
+  math(EXPR per_site_bytes "${object_size} / ${SITES}")
+
+  message(STATUS "  ${name}")
+  message(STATUS
+      "    build time   ${elapsed_ms} ms (${per_site_us} us per site)")
+  message(STATUS
+      "    object size  ${object_kib} KiB (${per_site_bytes} bytes per site)")
+endfunction()
+
+measure(header_only "")
+# The formatters and the engine are then only declared, as when linking
+# format_core.
+measure(format_core "-DFORMAT_CORE_LIBRARY")
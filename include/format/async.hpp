@@ -0,0 +1,786 @@
+#ifndef FORMAT_ASYNC_HPP_
+#define FORMAT_ASYNC_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ostream>
+#include <ranges>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "format/buffer.hpp"
+#include "format/concept.hpp"
+#include "format/format.hpp"
+#include "format/formatter.hpp"
+#include "format/param.hpp"
+#include "format/print.hpp"
+#include "format/runtime.hpp"
+
+namespace fmt {
+
+/// @brief What `async_print` does when the calling thread's queue is full.
+enum class QueuePolicy : ::fmt::u8 {
+  /// @brief Wait for the worker to make room.
+  Block,
+  /// @brief Discard the message and count it.
+  Drop,
+  /// @brief Format and write on the calling thread. The message may then
+  /// appear before ones still queued.
+  Sync,
+};
+
+struct AsyncOptions {
+  /// @brief Queue size per producing thread, in bytes.
+  ::std::size_t ring_size_{::std::size_t{1} << 16};
+  QueuePolicy policy_{QueuePolicy::Block};
+};
+
+struct AsyncStats {
+  ::fmt::u64 queued_;
+  ::fmt::u64 dropped_;
+  ::fmt::u64 synchronous_;
+};
+
+/// @brief Where an asynchronous message goes: a C stream, a file descriptor
+/// or a `std::ostream`. Writes to a sink are serialised by the library, but
+/// the sink must outlive every message queued for it.
+class AsyncSink {
+ public:
+  AsyncSink(::std::FILE* file) noexcept  // NOLINT
+      : kind_{Kind::File}, target_{file} {}
+#if FORMAT_HAS_WRITEV
+  AsyncSink(const int fd) noexcept  // NOLINT
+      : kind_{Kind::Descriptor}, fd_{fd} {}
+#endif
+  AsyncSink(::std::ostream& stream) noexcept  // NOLINT
+      : kind_{Kind::Stream}, target_{&stream} {}
+
+  auto write(const ::std::string_view text) const -> void {
+    switch (kind_) {
+      case Kind::File: {
+        ::std::fwrite(text.data(), 1, text.size(),
+                      static_cast<::std::FILE*>(target_));
+        break;
+      }
+      case Kind::Descriptor: {
+#if FORMAT_HAS_WRITEV
+        const detail::OutputSpan span{text.data(), text.size()};
+        detail::write_all(fd_, &span, 1);
+#endif
+        break;
+      }
+      case Kind::Stream: {
+        static_cast<::std::ostream*>(target_)->write(
+            text.data(), static_cast<::std::streamsize>(text.size()));
+        break;
+      }
+    }
+  }
+
+  auto flush() const -> void {
+    switch (kind_) {
+      case Kind::File: {
+        ::std::fflush(static_cast<::std::FILE*>(target_));
+        break;
+      }
+      case Kind::Descriptor: {
+        break;
+      }
+      case Kind::Stream: {
+        static_cast<::std::ostream*>(target_)->flush();
+        break;
+      }
+    }
+  }
+
+  friend auto operator==(const AsyncSink&, const AsyncSink&) -> bool =
+                                                                     default;
+
+ private:
+  enum class Kind : ::fmt::u8 { File, Descriptor, Stream };
+
+  Kind kind_;
+  void* target_{nullptr};
+  int fd_{-1};
+};
+
+template <typename Iterator, typename Sentinel>
+struct JoinView;
+
+namespace detail {
+
+/// @brief The fixed part of every queued message. The payload follows at
+/// `AsyncHeaderSize`. A record without `process_` is padding before the
+/// ring wraps.
+struct AsyncRecord {
+  using Process = void (*)(Buffer&, ::std::byte*);
+
+  ::std::size_t size_;
+  Process process_;
+  AsyncSink sink_;
+};
+
+inline constexpr ::std::size_t AsyncAlign{16};
+
+constexpr inline auto async_align(const ::std::size_t size) noexcept
+    -> ::std::size_t {
+  return (size + AsyncAlign - 1) & ~(AsyncAlign - 1);
+}
+
+inline constexpr ::std::size_t AsyncHeaderSize{
+    async_align(sizeof(AsyncRecord))};
+
+/// @brief A single-producer, single-consumer byte ring holding
+/// variable-sized records. Positions only grow; the offset is the position
+/// modulo the power-of-two capacity. A record never wraps: the space left
+/// before the end is skipped instead.
+class AsyncRing {
+ public:
+  explicit AsyncRing(const ::std::size_t capacity)
+      : capacity_{::std::bit_ceil(
+            ::std::max<::std::size_t>(capacity, AsyncHeaderSize * 16))},
+        data_{static_cast<::std::byte*>(
+            ::operator new(capacity_, ::std::align_val_t{AsyncAlign}))} {}
+  AsyncRing(const AsyncRing&) = delete;
+  auto operator=(const AsyncRing&) -> AsyncRing& = delete;
+  ~AsyncRing() { ::operator delete(data_, ::std::align_val_t{AsyncAlign}); }
+
+  auto capacity() const noexcept -> ::std::size_t { return capacity_; }
+
+  /// @brief Producer side: `size` bytes for the next record, or `nullptr`
+  /// if the ring is full. The record becomes visible on `publish`.
+  auto try_claim(const ::std::size_t size, const AsyncSink sink)
+      -> ::std::byte* {
+    const auto tail{tail_.load(::std::memory_order_relaxed)};
+    const auto offset{tail & (capacity_ - 1)};
+    const auto contiguous{capacity_ - offset};
+    const auto skip{contiguous < size ? contiguous : 0};
+    if (tail + skip + size - head_cache_ > capacity_) {
+      head_cache_ = head_.load(::std::memory_order_acquire);
+      if (tail + skip + size - head_cache_ > capacity_) {
+        return nullptr;
+      }
+    }
+    if (skip >= AsyncHeaderSize) {
+      ::new (data_ + offset) AsyncRecord{skip, nullptr, sink};
+    }
+    pending_ = tail + skip + size;
+    return data_ + ((tail + skip) & (capacity_ - 1));
+  }
+
+  auto publish() noexcept -> void {
+    tail_.store(pending_, ::std::memory_order_release);
+  }
+
+  /// @brief Producer side: counts the consumer's drains, for
+  /// `wait_for_room`. Read before the `try_claim` that failed.
+  auto room_epoch() const noexcept -> ::fmt::u32 {
+    return room_.load(::std::memory_order_acquire);
+  }
+
+  /// @brief Producer side, after `try_claim` failed: sleeps until the
+  /// consumer frees some space since `epoch`. Returns false once the ring
+  /// is abandoned, as nothing will free any.
+  auto wait_for_room(const ::fmt::u32 epoch) const noexcept -> bool {
+    if (abandoned()) {
+      return false;
+    }
+    room_.wait(epoch, ::std::memory_order_acquire);
+    return not abandoned();
+  }
+
+  /// @brief Consumer side, when it stops for good: wakes a producer waiting
+  /// for room, which then writes on its own thread, as later calls do.
+  auto abandon() noexcept -> void {
+    abandoned_.store(true, ::std::memory_order_release);
+    room_.fetch_add(1, ::std::memory_order_release);
+    room_.notify_all();
+  }
+  auto abandoned() const noexcept -> bool {
+    return abandoned_.load(::std::memory_order_acquire);
+  }
+
+  /// @brief Consumer side: whether a published record is waiting.
+  auto pending() const noexcept -> bool {
+    return head_.load(::std::memory_order_relaxed) not_eq
+           tail_.load(::std::memory_order_acquire);
+  }
+
+  /// @brief Consumer side: hands every published record to
+  /// `consume(record, payload)`. Returns whether there were any.
+  template <typename Consume>
+  auto drain(Consume consume) -> bool {
+    auto head{head_.load(::std::memory_order_relaxed)};
+    const auto tail{tail_.load(::std::memory_order_acquire)};
+    const bool any{head not_eq tail};
+    while (head not_eq tail) {
+      const auto offset{head & (capacity_ - 1)};
+      const auto contiguous{capacity_ - offset};
+      if (contiguous < AsyncHeaderSize) {
+        head += contiguous;
+        continue;
+      }
+      const auto* const record{
+          ::std::launder(reinterpret_cast<AsyncRecord*>(data_ + offset))};
+      const auto size{record->size_};
+      if (record->process_) {
+        consume(*record, data_ + offset + AsyncHeaderSize);
+      }
+      head += size;
+      head_.store(head, ::std::memory_order_release);
+    }
+    if (any) {
+      room_.fetch_add(1, ::std::memory_order_release);
+      room_.notify_one();
+    }
+    return any;
+  }
+
+  /// @brief Called when the producing thread exits.
+  auto close() noexcept -> void {
+    closed_.store(true, ::std::memory_order_release);
+  }
+  auto closed() const noexcept -> bool {
+    return closed_.load(::std::memory_order_acquire);
+  }
+
+  /// @brief Counters, written only by the producing thread.
+  ::std::atomic<::fmt::u64> queued_{0};
+  ::std::atomic<::fmt::u64> dropped_{0};
+  ::std::atomic<::fmt::u64> synchronous_{0};
+
+ private:
+  ::std::size_t capacity_;
+  ::std::byte* data_;
+  ::std::atomic<bool> closed_{false};
+  ::std::atomic<bool> abandoned_{false};
+
+  alignas(64) ::std::atomic<::std::size_t> tail_{0};
+  ::std::size_t pending_{0};
+  ::std::size_t head_cache_{0};
+
+  alignas(64) ::std::atomic<::std::size_t> head_{0};
+  ::std::atomic<::fmt::u32> room_{0};
+};
+
+inline auto bump(::std::atomic<::fmt::u64>& counter) noexcept -> void {
+  counter.store(counter.load(::std::memory_order_relaxed) + 1,
+                ::std::memory_order_relaxed);
+}
+
+/// @brief A string argument copied into the payload, after the values.
+struct AsyncString {
+  ::std::size_t offset_;
+  ::std::size_t size_;
+};
+
+/// @brief Arguments that refer to data they do not own, such as a
+/// `std::span` or `fmt::join`. The data may be gone by the time the worker
+/// formats them. Strings are copied, so they are not among these.
+template <typename Type>
+inline constexpr bool IsAsyncReference =
+    ::std::ranges::view<Type> and not IsString<Type>;
+
+template <typename Iterator, typename Sentinel>
+inline constexpr bool IsAsyncReference<JoinView<Iterator, Sentinel>> = true;
+
+/// @brief How an argument is kept in the queue: strings by their bytes,
+/// anything else as a copy of the value. Named arguments keep their value;
+/// the name was resolved with the format string.
+template <typename Type>
+using AsyncStored = ::std::conditional_t<IsString<ArgValue<Type>>,
+                                         AsyncString, ArgValue<Type>>;
+
+/// @brief The argument type the worker formats.
+template <typename Type>
+using AsyncDecoded = ::std::conditional_t<IsString<ArgValue<Type>>,
+                                          ::std::string_view, ArgValue<Type>>;
+
+/// @brief Every distinct format string queued with `Args`, parsed, for the
+/// life of the program, so a record refers to it rather than carrying its
+/// segment table. Format strings are constants, so their text is never
+/// freed or reused and is matched by address.
+template <typename... Args>
+class AsyncFormats {
+ public:
+  static auto intern(const FormatString<Args...>& fmt)
+      -> const FormatString<Args...>* {
+    thread_local const Node* last{nullptr};
+    if (last not_eq nullptr and matches(*last, fmt)) [[likely]] {
+      return &last->fmt_;
+    }
+    for (const Node* node{head_.load(::std::memory_order_acquire)};
+         node not_eq nullptr; node = node->next_) {
+      if (matches(*node, fmt)) {
+        last = node;
+        return &node->fmt_;
+      }
+    }
+    // Two threads may add the same string; either copy will do.
+    auto* const node{new Node{fmt, head_.load(::std::memory_order_relaxed)}};
+    while (not head_.compare_exchange_weak(node->next_, node,
+                                           ::std::memory_order_release,
+                                           ::std::memory_order_relaxed)) {
+    }
+    last = node;
+    return &node->fmt_;
+  }
+
+ private:
+  struct Node {
+    FormatString<Args...> fmt_;
+    const Node* next_;
+  };
+
+  static auto matches(const Node& node, const FormatString<Args...>& fmt)
+      noexcept -> bool {
+    return node.fmt_.get_fmt().data() == fmt.get_fmt().data() and
+           node.fmt_.length() == fmt.length();
+  }
+
+  static inline ::std::atomic<const Node*> head_{nullptr};
+};
+
+/// @brief Encodes the checked format string and the arguments of one call
+/// into a record payload, and formats and destroys them on the worker. The
+/// record holds a pointer to the interned format string, see
+/// `AsyncFormats`, so it is neither copied nor parsed again.
+template <typename... Args>
+struct AsyncPayload {
+  using Values =
+      ::std::tuple<const FormatString<Args...>*, AsyncStored<Args>...>;
+
+  static_assert(alignof(Values) <= AsyncAlign,
+                "async_print arguments must not be over-aligned");
+  static_assert((::std::is_copy_constructible_v<AsyncStored<Args>> and ...),
+                "async_print copies its arguments");
+  static_assert((not IsAsyncReference<ArgValue<Args>> and ...),
+                "async_print formats on the worker, after the call returns; "
+                "views such as std::span or fmt::join would dangle, so pass "
+                "an owning container or format the text first");
+
+  static auto size(const Args&... args) noexcept -> ::std::size_t {
+    return sizeof(Values) + (string_size<Args>(args) + ... + 0);
+  }
+
+  static auto store(::std::byte* payload, const FormatString<Args...>& fmt,
+                    const Args&... args) -> void {
+    [[maybe_unused]] ::std::size_t offset{sizeof(Values)};
+    ::new (payload) Values{AsyncFormats<Args...>::intern(fmt),
+                           store_one<Args>(payload, offset, args)...};
+  }
+
+  static auto process(Buffer& out, ::std::byte* payload) -> void {
+    auto* const values{::std::launder(reinterpret_cast<Values*>(payload))};
+    struct Destroy {
+      ~Destroy() { ::std::destroy_at(values_); }
+      Values* values_;
+    } destroy{values};
+    format_values(out, *values, payload,
+                  ::std::index_sequence_for<Args...>{});
+  }
+
+ private:
+  template <typename Type>
+  static auto string_size(const Type& arg) noexcept -> ::std::size_t {
+    if constexpr (IsString<ArgValue<Type>>) {
+      return ::std::string_view{unwrap_named(arg)}.size();
+    } else {
+      return 0;
+    }
+  }
+
+  template <typename Type>
+  static auto store_one(::std::byte* payload, ::std::size_t& offset,
+                        const Type& arg) -> AsyncStored<Type> {
+    if constexpr (IsString<ArgValue<Type>>) {
+      const ::std::string_view text{unwrap_named(arg)};
+      ::std::memcpy(payload + offset, text.data(), text.size());
+      const AsyncString stored{offset, text.size()};
+      offset += text.size();
+      return stored;
+    } else {
+      return unwrap_named(arg);
+    }
+  }
+
+  template <typename Type>
+  static auto decode(const AsyncStored<Type>& stored,
+                     const ::std::byte* payload) -> decltype(auto) {
+    if constexpr (IsString<ArgValue<Type>>) {
+      return ::std::string_view{
+          reinterpret_cast<const char*>(payload + stored.offset_),
+          stored.size_};
+    } else {
+      return (stored);
+    }
+  }
+
+  template <::std::size_t... Index>
+  static auto format_values(Buffer& out, const Values& values,
+                            [[maybe_unused]] const ::std::byte* payload,
+                            ::std::index_sequence<Index...>) -> void {
+    const FormatArgs<AsyncDecoded<Args>...> args{
+        decode<Args>(::std::get<Index + 1>(values), payload)...};
+    detail::vformat_to(out, ::std::get<0>(values)->view(), args.view());
+  }
+};
+
+/// @brief Owns the worker thread and the rings of every producing thread.
+/// Started by the first `async_print`, shut down at exit.
+class AsyncLogger {
+ public:
+  static auto instance() -> AsyncLogger& {
+    static AsyncLogger logger{};
+    return logger;
+  }
+
+  AsyncLogger(const AsyncLogger&) = delete;
+  auto operator=(const AsyncLogger&) -> AsyncLogger& = delete;
+  ~AsyncLogger() { shutdown(); }
+
+  /// @brief Starts the worker. Returns false once the logger has been shut
+  /// down.
+  auto start(const AsyncOptions& options) -> bool {
+    const ::std::lock_guard lock{state_mutex_};
+    if (shut_down_) {
+      return false;
+    }
+    if (not running_.load(::std::memory_order_relaxed)) {
+      options_ = options;
+      worker_ = ::std::thread{[this] { run(); }};
+      running_.store(true, ::std::memory_order_release);
+    }
+    return true;
+  }
+
+  template <typename... Args>
+  auto push(const AsyncSink sink, const FormatString<Args...>& fmt,
+            const Args&... args) -> void {
+    using Payload = AsyncPayload<Args...>;
+
+    if (not running_.load(::std::memory_order_acquire) and
+        not start(AsyncOptions{})) [[unlikely]] {
+      write_now(sink, fmt, args...);
+      return;
+    }
+
+    AsyncRing& ring{local_ring()};
+    const auto size{async_align(AsyncHeaderSize + Payload::size(args...))};
+    if (size > ring.capacity() / 2 or ring.abandoned()) [[unlikely]] {
+      bump(ring.synchronous_);
+      write_now(sink, fmt, args...);
+      return;
+    }
+
+    ::std::byte* record{ring.try_claim(size, sink)};
+    while (record == nullptr) {
+      switch (options_.policy_) {
+        case QueuePolicy::Block: {
+          // Tried again after reading the epoch, so a drain in between is
+          // not slept through.
+          const auto epoch{ring.room_epoch()};
+          record = ring.try_claim(size, sink);
+          if (record == nullptr and not ring.wait_for_room(epoch)) {
+            bump(ring.synchronous_);
+            write_now(sink, fmt, args...);
+            return;
+          }
+          break;
+        }
+        case QueuePolicy::Drop: {
+          bump(ring.dropped_);
+          return;
+        }
+        case QueuePolicy::Sync: {
+          bump(ring.synchronous_);
+          write_now(sink, fmt, args...);
+          return;
+        }
+      }
+    }
+
+    ::new (record) AsyncRecord{size, &Payload::process, sink};
+    Payload::store(record + AsyncHeaderSize, fmt, args...);
+    ring.publish();
+    bump(ring.queued_);
+
+    // Pairs with the fence in `sleep`: either the worker sees this record
+    // before it sleeps, or this sees it asleep.
+    ::std::atomic_thread_fence(::std::memory_order_seq_cst);
+    if (sleeping_.load(::std::memory_order_relaxed)) [[unlikely]] {
+      wake();
+    }
+  }
+
+  /// @brief Blocks until everything queued before the call is written and
+  /// its sinks are flushed.
+  auto flush() -> void {
+    ::std::unique_lock lock{state_mutex_};
+    if (not running_.load(::std::memory_order_relaxed)) {
+      return;
+    }
+    const auto ticket{++flush_requested_};
+    wake();
+    flushed_.wait(lock, [&] {
+      return flush_done_ >= ticket or
+             not running_.load(::std::memory_order_relaxed);
+    });
+  }
+
+  /// @brief Writes everything still queued and stops the worker. Later
+  /// messages, and those of threads waiting for room, are written on the
+  /// calling thread. Messages queued while this runs may be lost.
+  auto shutdown() -> void {
+    {
+      const ::std::lock_guard lock{state_mutex_};
+      shut_down_ = true;
+      if (not running_.load(::std::memory_order_relaxed)) {
+        return;
+      }
+      stopping_ = true;
+    }
+    wake();
+    worker_.join();
+
+    const ::std::lock_guard lock{state_mutex_};
+    running_.store(false, ::std::memory_order_release);
+    flushed_.notify_all();
+  }
+
+  auto stats() -> AsyncStats {
+    const ::std::lock_guard lock{rings_mutex_};
+    AsyncStats stats{retired_};
+    for (const auto& ring : rings_) {
+      add(stats, *ring);
+    }
+    return stats;
+  }
+
+ private:
+  AsyncLogger() = default;
+
+  /// @brief Keeps the calling thread's ring alive and marks it closed when
+  /// the thread exits, so the worker can drain and drop it.
+  struct RingHandle {
+    ~RingHandle() {
+      if (ring_) {
+        ring_->close();
+      }
+    }
+    ::std::shared_ptr<AsyncRing> ring_;
+  };
+
+  auto local_ring() -> AsyncRing& {
+    thread_local RingHandle handle{};
+    if (not handle.ring_) [[unlikely]] {
+      handle.ring_ = ::std::make_shared<AsyncRing>(options_.ring_size_);
+      const ::std::lock_guard lock{rings_mutex_};
+      rings_.push_back(handle.ring_);
+    }
+    return *handle.ring_;
+  }
+
+  template <typename... Args>
+  auto write_now(const AsyncSink sink, const FormatString<Args...>& fmt,
+                 const Args&... args) -> void {
+    const FormatArgs<Args...> format_args{args...};
+    MemoryBuffer<512> buf{};
+    _format_impl(fmt, format_args, buf);
+    const ::std::lock_guard lock{sink_mutex_};
+    sink.write(buf.view());
+  }
+
+  /// @brief Wakes the worker if it sleeps, or stops it from starting to.
+  auto wake() noexcept -> void {
+    wake_epoch_.fetch_add(1, ::std::memory_order_release);
+    wake_epoch_.notify_one();
+  }
+
+  /// @brief Sleeps until `wake` has been called since `epoch` was read,
+  /// unless a record was published meanwhile.
+  auto sleep(const ::fmt::u32 epoch) -> void {
+    sleeping_.store(true, ::std::memory_order_relaxed);
+    ::std::atomic_thread_fence(::std::memory_order_seq_cst);
+    bool pending{false};
+    {
+      const ::std::lock_guard lock{rings_mutex_};
+      for (const auto& ring : rings_) {
+        pending = pending or ring->pending();
+      }
+    }
+    if (not pending) {
+      wake_epoch_.wait(epoch, ::std::memory_order_acquire);
+    }
+    sleeping_.store(false, ::std::memory_order_relaxed);
+  }
+
+  static auto add(AsyncStats& stats, const AsyncRing& ring) noexcept
+      -> void {
+    stats.queued_ += ring.queued_.load(::std::memory_order_relaxed);
+    stats.dropped_ += ring.dropped_.load(::std::memory_order_relaxed);
+    stats.synchronous_ +=
+        ring.synchronous_.load(::std::memory_order_relaxed);
+  }
+
+  /// @brief Formats consecutive records for the same sink into one buffer
+  /// and writes it in one go.
+  auto run() -> void {
+    MemoryBuffer<4096> out{};
+    ::std::optional<AsyncSink> current{};
+    ::std::vector<AsyncSink> written{};
+
+    const auto emit{[&] {
+      if (out.size() not_eq 0) {
+        const ::std::lock_guard lock{sink_mutex_};
+        try {
+          current->write(out.view());
+        } catch (...) {
+          // The worker must keep going; there is nobody to report to.
+        }
+        if (::std::find(written.begin(), written.end(), *current) ==
+            written.end()) {
+          written.push_back(*current);
+        }
+      }
+      out.clear();
+    }};
+    const auto consume{[&](const AsyncRecord& record, ::std::byte* payload) {
+      if (current not_eq record.sink_ or out.size() >= 4096) {
+        emit();
+        current = record.sink_;
+      }
+      try {
+        record.process_(out, payload);
+      } catch (...) {
+        // A throwing Formatter loses its own message only.
+      }
+    }};
+
+    while (true) {
+      // Read first, so a `wake` for anything after this is not missed.
+      const auto epoch{wake_epoch_.load(::std::memory_order_acquire)};
+      ::std::size_t requested{};
+      bool stopping{};
+      {
+        const ::std::lock_guard lock{state_mutex_};
+        requested = flush_requested_;
+        stopping = stopping_;
+      }
+
+      bool worked{false};
+      {
+        const ::std::lock_guard lock{rings_mutex_};
+        for (auto it = rings_.begin(); it not_eq rings_.end();) {
+          const bool closed{(*it)->closed()};
+          worked = (*it)->drain(consume) or worked;
+          if (closed) {
+            add(retired_, **it);
+            it = rings_.erase(it);
+          } else {
+            ++it;
+          }
+        }
+      }
+      emit();
+      if (worked) {
+        continue;
+      }
+
+      {
+        const ::std::lock_guard lock{sink_mutex_};
+        for (const auto& sink : written) {
+          sink.flush();
+        }
+      }
+      written.clear();
+
+      {
+        const ::std::lock_guard lock{state_mutex_};
+        if (flush_done_ < requested) {
+          flush_done_ = requested;
+          flushed_.notify_all();
+        }
+        if (stopping) {
+          break;
+        }
+      }
+      sleep(epoch);
+    }
+
+    // Nothing drains the rings from here on.
+    const ::std::lock_guard lock{rings_mutex_};
+    for (const auto& ring : rings_) {
+      ring->abandon();
+    }
+  }
+
+  AsyncOptions options_{};
+  ::std::atomic<bool> running_{false};
+
+  ::std::atomic<::fmt::u32> wake_epoch_{0};
+  ::std::atomic<bool> sleeping_{false};
+
+  ::std::mutex state_mutex_{};
+  ::std::condition_variable flushed_{};
+  ::std::size_t flush_requested_{0};
+  ::std::size_t flush_done_{0};
+  bool stopping_{false};
+  bool shut_down_{false};
+  ::std::thread worker_{};
+
+  ::std::mutex rings_mutex_{};
+  ::std::vector<::std::shared_ptr<AsyncRing>> rings_{};
+  AsyncStats retired_{0, 0, 0};
+
+  ::std::mutex sink_mutex_{};
+};
+
+}  // namespace detail
+
+/// @brief Starts the background worker with `options`. Optional: the first
+/// `async_print` starts it with the defaults. Has no effect once running.
+inline auto async_start(const AsyncOptions& options = {}) -> void {
+  detail::AsyncLogger::instance().start(options);
+}
+
+/// @brief Queues a message for the background worker. The calling thread
+/// only copies the checked format string and the arguments, with strings
+/// copied by value, into its own lock-free ring; formatting and I/O happen
+/// on the worker. Messages from one thread keep their order. Views such as
+/// `std::span` are rejected, as they would dangle.
+template <typename... Args>
+auto async_print(const AsyncSink sink, const FormatString<Args...> fmt,
+                 const Args&... args) -> void {
+  detail::AsyncLogger::instance().push(sink, fmt, args...);
+}
+
+/// @brief Waits until every message queued so far has been written.
+inline auto async_flush() -> void { detail::AsyncLogger::instance().flush(); }
+
+/// @brief Writes what is queued and stops the worker. Runs automatically
+/// at exit.
+inline auto async_shutdown() -> void {
+  detail::AsyncLogger::instance().shutdown();
+}
+
+inline auto async_stats() -> AsyncStats {
+  return detail::AsyncLogger::instance().stats();
+}
+
+}  // namespace fmt
+
+#endif  // FORMAT_ASYNC_HPP_
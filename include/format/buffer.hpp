@@ -0,0 +1,380 @@
+#ifndef FORMAT_BUFFER_HPP_
+#define FORMAT_BUFFER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#include "format/instrument.hpp"
+
+namespace fmt {
+
+/// @brief The contiguous output sink every `Formatter` writes through.
+/// Concrete buffers supply the storage and a grow hook, which may allocate,
+/// flush to a destination, or start discarding once a fixed limit is reached.
+class Buffer {
+ public:
+  Buffer(const Buffer&) = delete;
+  auto operator=(const Buffer&) -> Buffer& = delete;
+
+  constexpr inline auto size() const noexcept -> ::std::size_t {
+    return size_;
+  }
+  constexpr inline auto capacity() const noexcept -> ::std::size_t {
+    return capacity_;
+  }
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+  /// @brief Characters written over the buffer's lifetime, including those
+  /// already flushed.
+  constexpr inline auto produced() const noexcept -> ::std::size_t {
+    return flushed_ + size_;
+  }
+#endif
+  constexpr inline auto data() noexcept -> char* { return ptr_; }
+  constexpr inline auto data() const noexcept -> const char* { return ptr_; }
+  constexpr inline auto clear() noexcept -> void { size_ = 0; }
+
+  /// @brief Asks the buffer to make room for `count` characters in total.
+  /// Buffers that cannot grow may free less than that.
+  constexpr inline auto try_reserve(const ::std::size_t count) -> void {
+    if (count > capacity_) {
+      grow_(*this, count);
+    }
+  }
+
+  constexpr inline auto push_back(const char c) -> void {
+    try_reserve(size_ + 1);
+    ptr_[size_++] = c;
+  }
+
+  constexpr inline auto append(const ::std::string_view str) -> void {
+    const char* begin{str.data()};
+    const char* const end{str.data() + str.size()};
+    while (begin not_eq end) {
+      const auto count{copy_chunk(begin, static_cast<::std::size_t>(
+                                             end - begin))};
+      begin += count;
+    }
+  }
+
+  /// @brief Appends `count` copies of `fill`, for padding.
+  constexpr inline auto append(::std::size_t count, const char fill) -> void {
+    while (count not_eq 0) {
+      try_reserve(size_ + count);
+      const auto chunk{::std::min(count, capacity_ - size_)};
+      ::std::fill_n(ptr_ + size_, chunk, fill);
+      size_ += chunk;
+      count -= chunk;
+    }
+  }
+
+  /// @brief Hands out `count` contiguous characters at the end of the buffer
+  /// for in-place writes, or `nullptr` if the buffer cannot provide them.
+  constexpr inline auto claim(const ::std::size_t count) -> char* {
+    try_reserve(size_ + count);
+    if (capacity_ - size_ < count) {
+      return nullptr;
+    }
+    char* const out{ptr_ + size_};
+    size_ += count;
+    return out;
+  }
+
+ protected:
+  using Grow = void (*)(Buffer&, ::std::size_t);
+
+  constexpr explicit Buffer(Grow grow, char* ptr = nullptr,
+                            ::std::size_t size = 0,
+                            ::std::size_t capacity = 0) noexcept
+      : ptr_{ptr}, size_{size}, capacity_{capacity}, grow_{grow} {}
+  constexpr ~Buffer() = default;
+
+  constexpr inline auto set(char* ptr, const ::std::size_t capacity) noexcept
+      -> void {
+    ptr_ = ptr;
+    capacity_ = capacity;
+  }
+
+  /// @brief Records `count` characters handed on before `size_` is reset.
+  constexpr inline auto flushed([[maybe_unused]] const ::std::size_t count)
+      noexcept -> void {
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+    flushed_ += count;
+#endif
+  }
+
+  char* ptr_;
+  ::std::size_t size_;
+  ::std::size_t capacity_;
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+  ::std::size_t flushed_{0};
+#endif
+
+ private:
+  constexpr inline auto copy_chunk(const char* src, ::std::size_t count)
+      -> ::std::size_t {
+    try_reserve(size_ + count);
+    count = ::std::min(count, capacity_ - size_);
+    ::std::copy_n(src, count, ptr_ + size_);
+    size_ += count;
+    return count;
+  }
+
+  Grow grow_;
+};
+
+/// @brief A formatting target that keeps the first `InlineSize` characters in
+/// an inline array, so short output never touches the heap, and grows
+/// geometrically through `Allocator` only past that.
+template <::std::size_t InlineSize = 256,
+          typename Allocator = ::std::allocator<char>>
+class MemoryBuffer final : public Buffer {
+  using Traits = ::std::allocator_traits<Allocator>;
+
+ public:
+  constexpr MemoryBuffer() : MemoryBuffer{Allocator{}} {}
+  constexpr explicit MemoryBuffer(const Allocator& allocator)
+      : Buffer{grow}, allocator_{allocator} {
+    set(data_, InlineSize);
+  }
+  constexpr MemoryBuffer(MemoryBuffer&& other) noexcept
+      : Buffer{grow}, allocator_{::std::move(other.allocator_)} {
+    if (other.ptr_ == other.data_) {
+      ::std::copy_n(other.data_, other.size_, data_);
+      set(data_, InlineSize);
+    } else {
+      set(other.ptr_, other.capacity_);
+      other.set(other.data_, InlineSize);
+    }
+    size_ = other.size_;
+    other.size_ = 0;
+  }
+  auto operator=(MemoryBuffer&&) -> MemoryBuffer& = delete;
+  constexpr ~MemoryBuffer() { deallocate(); }
+
+  constexpr inline auto view() const noexcept -> ::std::string_view {
+    return {ptr_, size_};
+  }
+  // NOLINTBEGIN
+  constexpr operator ::std::string_view() const noexcept { return view(); }
+  // NOLINTEND
+
+  /// @brief Copies the contents into a string with a single exact-size
+  /// allocation, as `std::string` cannot adopt foreign storage.
+  template <typename String = ::std::string>
+  constexpr inline auto str(
+      const typename String::allocator_type& allocator = {}) const
+      -> String {
+    String out{ptr_, size_, allocator};
+    if constexpr (instrumentation::Enabled) {
+      detail::count_growth(String{allocator}.capacity(), out.capacity());
+    }
+    return out;
+  }
+
+  constexpr inline auto get_allocator() const noexcept -> Allocator {
+    return allocator_;
+  }
+
+ private:
+  constexpr inline auto deallocate() -> void {
+    if (ptr_ not_eq data_) {
+      Traits::deallocate(allocator_, ptr_, capacity_);
+    }
+  }
+
+  static constexpr auto grow(Buffer& buf, const ::std::size_t count) -> void {
+    auto& self{static_cast<MemoryBuffer&>(buf)};
+    detail::count(detail::Counter::Regrowths);
+    detail::count(detail::Counter::Allocations);
+    const auto capacity{::std::max(count, self.capacity_ * 2)};
+    char* const data{Traits::allocate(self.allocator_, capacity)};
+    ::std::copy_n(self.ptr_, self.size_, data);
+    self.deallocate();
+    self.set(data, capacity);
+  }
+
+  [[no_unique_address]] Allocator allocator_;
+  char data_[InlineSize]{};
+};
+
+namespace pmr {
+template <::std::size_t InlineSize = 256>
+using MemoryBuffer =
+    ::fmt::MemoryBuffer<InlineSize, ::std::pmr::polymorphic_allocator<char>>;
+}  // namespace pmr
+
+namespace detail {
+
+/// @brief Writes into a contiguous container (`std::string`, `std::vector`)
+/// using its elements as storage, growing it geometrically. The container
+/// is trimmed to the written size on destruction.
+template <typename Container>
+class ContainerBuffer final : public Buffer {
+ public:
+  /// @brief `reserve` is the expected output size, such as an exact size
+  /// from `size_hint`; growing past it counts as a reserve miss.
+  constexpr explicit ContainerBuffer(Container& container,
+                                     const ::std::size_t reserve = 0)
+      : Buffer{grow, nullptr, container.size()}, container_{container} {
+    resize(size_ + reserve);
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+    estimated_ = reserve not_eq 0;
+#endif
+  }
+  constexpr ~ContainerBuffer() { container_.resize(size_); }
+
+ private:
+  constexpr inline auto resize(const ::std::size_t size) -> void {
+    const auto before{container_.capacity()};
+    container_.resize(size);
+    count_growth(before, container_.capacity());
+    set(container_.data(), container_.size());
+  }
+
+  static constexpr auto grow(Buffer& buf, const ::std::size_t count) -> void {
+    auto& self{static_cast<ContainerBuffer&>(buf)};
+    detail::count(Counter::Regrowths);
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+    if (self.estimated_) {
+      detail::count(Counter::ReserveMisses);
+      self.estimated_ = false;
+    }
+#endif
+    self.resize(::std::max(count, self.capacity_ * 2));
+  }
+
+  Container& container_;
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+  bool estimated_{false};
+#endif
+};
+
+/// @brief Writes into caller-provided memory of a fixed size. Once it is full,
+/// output is only counted, so the caller can learn the untruncated size.
+class FixedBuffer final : public Buffer {
+ public:
+  constexpr FixedBuffer(char* out, const ::std::size_t limit) noexcept
+      : Buffer{grow, out, 0, limit}, limit_{limit} {}
+
+  /// @brief Number of characters that would have been written without the
+  /// limit.
+  constexpr inline auto count() const noexcept -> ::std::size_t {
+    return overflowed_ ? limit_ + discarded_ + size_ : size_;
+  }
+  constexpr inline auto written() const noexcept -> ::std::size_t {
+    return overflowed_ ? limit_ : size_;
+  }
+
+ private:
+  static constexpr auto grow(Buffer& buf,
+                             [[maybe_unused]] const ::std::size_t count)
+      -> void {
+    auto& self{static_cast<FixedBuffer&>(buf)};
+    if (self.size_ < self.capacity_) {
+      // Let the caller fill what is left before spilling into the scratch.
+      return;
+    }
+    if (self.overflowed_) {
+      self.discarded_ += self.size_;
+    }
+    self.flushed(self.size_);
+    self.overflowed_ = true;
+    self.size_ = 0;
+    self.set(self.scratch_, sizeof(self.scratch_));
+  }
+
+  ::std::size_t limit_;
+  ::std::size_t discarded_{0};
+  bool overflowed_{false};
+  char scratch_[64]{};
+};
+
+/// @brief Stages output in a small local array and flushes it to an arbitrary
+/// output iterator, stopping after `limit` characters.
+template <typename OutputIt>
+class IteratorBuffer final : public Buffer {
+ public:
+  constexpr explicit IteratorBuffer(
+      OutputIt out,
+      ::std::size_t limit = ::std::numeric_limits<::std::size_t>::max())
+      : Buffer{grow}, out_{out}, limit_{limit} {
+    set(data_, sizeof(data_));
+  }
+
+  constexpr inline auto flush() -> void {
+    const auto count{::std::min(size_, limit_)};
+    out_ = ::std::copy_n(data_, count, out_);
+    limit_ -= count;
+    count_ += size_;
+    flushed(size_);
+    size_ = 0;
+  }
+  constexpr inline auto out() const noexcept -> OutputIt { return out_; }
+  constexpr inline auto count() const noexcept -> ::std::size_t {
+    return count_ + size_;
+  }
+
+ private:
+  static constexpr auto grow(Buffer& buf,
+                             [[maybe_unused]] const ::std::size_t count)
+      -> void {
+    static_cast<IteratorBuffer&>(buf).flush();
+  }
+
+  OutputIt out_;
+  ::std::size_t limit_;
+  ::std::size_t count_{0};
+  char data_[256]{};
+};
+
+template <typename Container>
+constexpr inline auto get_container(
+    ::std::back_insert_iterator<Container> it) noexcept -> Container& {
+  struct Accessor : ::std::back_insert_iterator<Container> {
+    constexpr explicit Accessor(::std::back_insert_iterator<Container> base)
+        : ::std::back_insert_iterator<Container>{base} {}
+    using ::std::back_insert_iterator<Container>::container;
+  };
+  return *Accessor{it}.container;
+}
+
+template <typename OutputIt>
+constexpr inline bool IsContiguousBackInserter = false;
+
+template <typename Container>
+  requires(::std::contiguous_iterator<typename Container::iterator> and
+           ::std::is_same_v<typename Container::value_type, char>)
+constexpr inline bool
+    IsContiguousBackInserter<::std::back_insert_iterator<Container>> = true;
+
+/// @brief Counts one formatting call, and the characters it adds to `out`
+/// by the time it ends.
+class CallScope {
+ public:
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+  constexpr explicit CallScope(const Buffer& out) noexcept
+      : out_{out}, start_{out.produced()} {}
+  constexpr ~CallScope() {
+    count(Counter::Calls);
+    count(Counter::Bytes, out_.produced() - start_);
+  }
+
+ private:
+  const Buffer& out_;
+  ::std::size_t start_;
+#else
+  constexpr explicit CallScope(const Buffer&) noexcept {}
+#endif
+};
+
+}  // namespace detail
+
+}  // namespace fmt
+
+#endif  // FORMAT_BUFFER_HPP_
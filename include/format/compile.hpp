@@ -0,0 +1,180 @@
+#ifndef FORMAT_COMPILE_HPP_
+#define FORMAT_COMPILE_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "format/buffer.hpp"
+#include "format/format.hpp"
+#include "format/formatter.hpp"
+#include "format/named.hpp"
+#include "format/param.hpp"
+#include "format/specifier.hpp"
+
+namespace fmt {
+
+/// @brief Tag carrying a format string in its type, see `fmt::compile`.
+template <FixedString Fmt>
+struct CompiledFormat {
+  static constexpr ::std::string_view Value{Fmt.view()};
+};
+
+/// @brief Opt-in compiled format string, `fmt::compile<"{} = {:x}">`. Each
+/// call expands into constant-length copies of the literal text and direct
+/// `Formatter<T>` calls with the specifiers baked in, so nothing is
+/// interpreted at runtime. With constant arguments, formatting can run
+/// entirely at compile time.
+template <FixedString Fmt>
+inline constexpr CompiledFormat<Fmt> compile{};
+
+namespace detail {
+
+/// @brief Copies `Size` characters known at compile time.
+template <::std::size_t Size>
+constexpr inline auto append_literal(Buffer& out, const char* literal)
+    -> void {
+  if constexpr (Size not_eq 0) {
+    if (char* const dest{out.claim(Size)}) {
+      ::std::copy_n(literal, Size, dest);
+    } else {
+      out.append(::std::string_view{literal, Size});
+    }
+  }
+}
+
+/// @brief Every field of `Fmt`, in a table of exactly their number. The
+/// string is in the type, so unlike `FormatString` nothing caps the table.
+template <FixedString Fmt, typename... Args>
+inline constexpr auto CompiledSegments{[] {
+  constexpr auto Names{FormatString<Args...>::Names};
+  constexpr ::std::size_t Count{[&] {
+    ::std::size_t count{0};
+    parse_segments(Fmt.view(), Names, [&](const FormatSegment&) { ++count; });
+    return count;
+  }()};
+  ::std::array<FormatSegment, Count> table{};
+  ::std::size_t index{0};
+  parse_segments(Fmt.view(), Names, [&](const FormatSegment& segment) {
+    table[index++] = segment;
+  });
+  return table;
+}()};
+
+/// @brief The format string parsed once, at compile time, for one set of
+/// argument types.
+template <FixedString Fmt, typename... Args>
+struct CompiledFields {
+  static constexpr FormatString<Args...> Parsed{Fmt.view()};
+  static constexpr auto& Segments{CompiledSegments<Fmt, Args...>};
+  static constexpr ::std::size_t Count{Segments.size()};
+
+  /// @brief The field's specifier, with a dynamic width or precision taken
+  /// from the arguments; a constant otherwise.
+  template <::std::size_t Index>
+  static constexpr inline auto specifier(
+      [[maybe_unused]] const Args&... args) -> FormatSpecifier {
+    constexpr FormatSpecifier Specifier{Segments[Index].specifier(Fmt.view())};
+    if constexpr (Specifier.is_dynamic()) {
+      const FormatArgs<Args...> erased{args...};
+      return resolve_dynamic(Specifier, erased.view());
+    } else {
+      return Specifier;
+    }
+  }
+
+  template <::std::size_t Index>
+  static constexpr inline auto write_field(Buffer& out, const Args&... args)
+      -> void {
+    constexpr FormatSegment Segment{Segments[Index]};
+    constexpr ::std::string_view Literal{Parsed.literal(Segment)};
+    append_literal<Literal.size()>(out, Literal.data());
+    write_arg(out, ::std::get<Segment.position_>(::std::tie(args...)),
+              specifier<Index>(args...));
+  }
+
+  template <::std::size_t Index>
+  static constexpr inline auto field_size(const Args&... args)
+      -> ::std::size_t {
+    constexpr FormatSegment Segment{Segments[Index]};
+    return arg_size(::std::get<Segment.position_>(::std::tie(args...)),
+                    specifier<Index>(args...));
+  }
+
+  template <::std::size_t... Index>
+  static constexpr inline auto write(Buffer& out,
+                                     ::std::index_sequence<Index...>,
+                                     const Args&... args) -> void {
+    (write_field<Index>(out, args...), ...);
+    constexpr ::std::string_view Tail{Parsed.tail()};
+    append_literal<Tail.size()>(out, Tail.data());
+  }
+
+  template <::std::size_t... Index>
+  static constexpr inline auto size(::std::index_sequence<Index...>,
+                                    const Args&... args) -> ::std::size_t {
+    return Parsed.literal_length() + (field_size<Index>(args...) + ... + 0);
+  }
+
+  static constexpr inline auto write(Buffer& out, const Args&... args)
+      -> void {
+    const CallScope scope{out};
+    write(out, ::std::make_index_sequence<Count>{}, args...);
+  }
+  static constexpr inline auto size(const Args&... args) -> ::std::size_t {
+    return size(::std::make_index_sequence<Count>{}, args...);
+  }
+};
+
+}  // namespace detail
+
+template <FixedString Fmt, typename... ArgsType>
+[[nodiscard]] constexpr auto formatted_size(CompiledFormat<Fmt>,
+                                            const ArgsType&... args)
+    -> ::std::size_t {
+  return detail::CompiledFields<Fmt, ArgsType...>::size(args...);
+}
+
+/// @brief Formats in a single pass, pre-sizing only for integers and
+/// strings, as the runtime-checked `format` does.
+template <FixedString Fmt, typename... ArgsType>
+[[nodiscard]] constexpr auto format(CompiledFormat<Fmt>,
+                                    const ArgsType&... args) -> ::std::string {
+  using Fields = detail::CompiledFields<Fmt, ArgsType...>;
+
+  ::std::string out{};
+  if constexpr ((detail::HasCheapSize<ArgsType> and ...)) {
+    detail::ContainerBuffer buf{out, Fields::size(args...)};
+    Fields::write(buf, args...);
+  } else {
+    MemoryBuffer<> buf{};
+    Fields::write(buf, args...);
+    out.append(buf.view());
+  }
+
+  return out;
+}
+
+template <FixedString Fmt, typename... ArgsType>
+constexpr auto format_to(Buffer& out, CompiledFormat<Fmt>,
+                         const ArgsType&... args) -> void {
+  detail::CompiledFields<Fmt, ArgsType...>::write(out, args...);
+}
+
+template <typename OutputIt, FixedString Fmt, typename... ArgsType>
+  requires ::std::output_iterator<OutputIt, const char&>
+constexpr auto format_to(OutputIt out, CompiledFormat<Fmt>,
+                         const ArgsType&... args) -> OutputIt {
+  return detail::write_to_iterator(out, [&](Buffer& buf) {
+    detail::CompiledFields<Fmt, ArgsType...>::write(buf, args...);
+  });
+}
+
+}  // namespace fmt
+
+#endif  // FORMAT_COMPILE_HPP_
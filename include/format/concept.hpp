@@ -1,8 +1,12 @@
 #ifndef FORMAT_CONCEPT_HPP_
 #define FORMAT_CONCEPT_HPP_
 
+#include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace fmt {
 
@@ -70,6 +74,12 @@ concept IsIntegerNoChar =
 template <typename Type>
 concept IsFloat = requires(Type) { requires(IsAnyOf<Type, FloatType>); };
 
+template <typename Type>
+concept IsString =
+    ::std::convertible_to<const Type&, ::std::string_view> and
+    (IsAnyOf<::std::decay_t<Type>, TypeList<const char*, char*>> or
+     IsAnyOf<Type, TypeList<::std::string, ::std::string_view>>);
+
 }  // namespace fmt
 
 #endif  // FORMAT_CONCEPT_HPP_
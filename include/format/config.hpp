@@ -0,0 +1,29 @@
+#ifndef FORMAT_CONFIG_HPP_
+#define FORMAT_CONFIG_HPP_
+
+/// @brief The library is header-only by default. Linking the `format_core`
+/// CMake target defines `FORMAT_CORE_LIBRARY`, which turns the non-template
+/// runtime engine into declarations and the builtin `Formatter`s into
+/// `extern template`s, all compiled once in `src/format_core.cc` (which also
+/// defines `FORMAT_CORE_SOURCE`).
+#if defined(FORMAT_CORE_LIBRARY)
+#define FORMAT_FUNC
+#if defined(FORMAT_CORE_SOURCE)
+#define FORMAT_DEFINE_CORE 1
+#else
+#define FORMAT_DEFINE_CORE 0
+#endif
+#else
+#define FORMAT_FUNC inline
+#define FORMAT_DEFINE_CORE 1
+#endif
+
+/// @brief SSE2 fast paths: GCC and Clang say when the target has it; MSVC
+/// does not define `__SSE2__`, but every x64 target has it.
+#if defined(__SSE2__) or defined(_M_X64) or defined(_M_AMD64)
+#define FORMAT_HAS_SSE2 1
+#else
+#define FORMAT_HAS_SSE2 0
+#endif
+
+#endif  // FORMAT_CONFIG_HPP_
@@ -1,11 +1,40 @@
 #ifndef FORMAT_DETAIL_HPP_
 #define FORMAT_DETAIL_HPP_
 
-#include <bitset>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "format/buffer.hpp"
+#include "format/unicode.hpp"
+
+namespace fmt {
+
+/// @brief Where a value sits in its field. `Default` is right for numbers and
+/// left for text.
+enum class Align : ::std::uint8_t { Default, Left, Right, Center };
+
+/// @brief What goes before a non-negative number: nothing, `+` or a space.
+enum class Sign : ::std::uint8_t { Minus, Plus, Space };
+
+}  // namespace fmt
 
 namespace fmt::detail {
 
+/// @brief The width a value is padded to, with what and on which side.
+/// `zero_` pads numbers with zeros after the sign and prefix instead.
+struct Padding {
+  ::std::size_t width_{0};
+  char fill_{' '};
+  Align align_{Align::Default};
+  bool zero_{false};
+};
+
 constexpr inline auto is_alpha(const char c) -> bool {
   return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z');
 }
@@ -13,57 +42,562 @@ constexpr inline auto is_digit(const char c) -> bool {
   return c >= '0' and c <= '9';
 }
 
-inline constexpr ::std::string_view const HexDigits{"0123456789ABCDEF"};
 template <typename Type>
-inline auto to_hex(Type n, [[maybe_unused]] ::std::size_t hex_len = 0ULL)
-    -> ::std::string {
-  constexpr auto Length{sizeof(Type) << 1};
-  std::string result{};
-  result.resize(Length);
+constexpr inline auto is_negative(const Type n) noexcept -> bool {
+  if constexpr (::std::is_signed_v<Type>) {
+    return n < 0;
+  } else {
+    return false;
+  }
+}
+
+/// @brief Number of decimal digits in `n`, at least one. The bit width gives
+/// the digit count up to one, a single power-of-ten comparison settles it.
+constexpr inline auto count_digits(const ::std::uint64_t n) noexcept
+    -> ::std::size_t {
+  constexpr ::std::uint8_t BitsToDigits[]{
+      1,  1,  1,  2,  2,  2,  3,  3,  3,  4,  4,  4,  4,  5,  5,  5,
+      6,  6,  6,  7,  7,  7,  7,  8,  8,  8,  9,  9,  9,  10, 10, 10,
+      10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 15, 15,
+      15, 16, 16, 16, 16, 17, 17, 17, 18, 18, 18, 19, 19, 19, 19, 20};
+  constexpr ::std::uint64_t PowersOfTen[]{0,
+                                          0,
+                                          10ULL,
+                                          100ULL,
+                                          1000ULL,
+                                          10000ULL,
+                                          100000ULL,
+                                          1000000ULL,
+                                          10000000ULL,
+                                          100000000ULL,
+                                          1000000000ULL,
+                                          10000000000ULL,
+                                          100000000000ULL,
+                                          1000000000000ULL,
+                                          10000000000000ULL,
+                                          100000000000000ULL,
+                                          1000000000000000ULL,
+                                          10000000000000000ULL,
+                                          100000000000000000ULL,
+                                          1000000000000000000ULL,
+                                          10000000000000000000ULL};
+  const auto digits{BitsToDigits[::std::bit_width(n | 1) - 1]};
+  return digits - (n < PowersOfTen[digits] ? 1 : 0);
+}
+
+inline constexpr char const DigitPairs[]{
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899"};
+
+/// @brief Writes the `digits` decimal digits of `n` ending at `out + digits`,
+/// two at a time from the back.
+template <typename Unsigned>
+constexpr inline auto write_decimal(char* const out, Unsigned n,
+                                    const ::std::size_t digits) noexcept
+    -> void {
+  char* ptr{out + digits};
+  while (n >= 100) {
+    const auto index{static_cast<::std::size_t>(n % 100) * 2};
+    n /= 100;
+    *--ptr = DigitPairs[index + 1];
+    *--ptr = DigitPairs[index];
+  }
+  if (n < 10) {
+    *--ptr = static_cast<char>('0' + n);
+  } else {
+    const auto index{static_cast<::std::size_t>(n) * 2};
+    *--ptr = DigitPairs[index + 1];
+    *--ptr = DigitPairs[index];
+  }
+}
+
+/// @brief The unsigned type integer kernels do their arithmetic in: 32 bits
+/// when the value fits, since that is cheaper to divide.
+template <typename Type>
+using KernelUnsigned =
+    ::std::conditional_t<sizeof(Type) <= sizeof(::std::uint32_t),
+                         ::std::uint32_t, ::std::uint64_t>;
+
+template <typename Type>
+constexpr inline auto magnitude(const Type n) noexcept
+    -> KernelUnsigned<Type> {
+  using Unsigned = KernelUnsigned<Type>;
+  return is_negative(n) ? static_cast<Unsigned>(Unsigned{0} -
+                                                static_cast<Unsigned>(n))
+                        : static_cast<Unsigned>(n);
+}
+
+/// @brief The sign written before a number, or 0 for none.
+constexpr inline auto sign_char(const bool negative, const Sign sign) noexcept
+    -> char {
+  if (negative) {
+    return '-';
+  }
+  return sign == Sign::Plus ? '+' : sign == Sign::Space ? ' ' : 0;
+}
+
+/// @brief The fill characters on either side of a value.
+struct Split {
+  ::std::size_t before_{0};
+  ::std::size_t after_{0};
+};
 
-  for (size_t current = 0, j = (Length - 1) * 4; current < Length;
-       ++current, j -= 4) {
-    result[current] = HexDigits[(n >> j) & 0x0f];
+/// @brief Splits the room left by a value of `size` characters in
+/// `padding.width_`; `fallback` stands in for the default alignment.
+constexpr inline auto split_padding(const Padding& padding,
+                                    const ::std::size_t size,
+                                    const Align fallback) noexcept -> Split {
+  if (padding.width_ <= size) {
+    return {};
   }
+  const auto room{padding.width_ - size};
+  switch (padding.align_ == Align::Default ? fallback : padding.align_) {
+    case Align::Left: {
+      return {0, room};
+    }
+    case Align::Center: {
+      return {room / 2, room - room / 2};
+    }
+    default: {
+      return {room, 0};
+    }
+  }
+}
+
+/// @brief The fill and zeros around a number of `size` characters. Zeros go
+/// after the sign and prefix, and only when no alignment is given.
+struct NumberPadding {
+  ::std::size_t before_{0};
+  ::std::size_t zeros_{0};
+  ::std::size_t after_{0};
+};
+
+constexpr inline auto number_padding(const Padding& padding,
+                                     const ::std::size_t size) noexcept
+    -> NumberPadding {
+  if (padding.zero_ and padding.align_ == Align::Default) {
+    return {0, padding.width_ > size ? padding.width_ - size : 0, 0};
+  }
+  const auto [before, after]{split_padding(padding, size, Align::Right)};
+  return {before, 0, after};
+}
+
+/// @brief Total length of an integer with its sign and prefix, padded to
+/// `width`.
+constexpr inline auto integer_size(const char sign, const ::std::size_t prefix,
+                                   const ::std::size_t digits,
+                                   const ::std::size_t width) noexcept
+    -> ::std::size_t {
+  const auto size{digits + prefix + (sign not_eq 0 ? 1 : 0)};
+  return width > size ? width : size;
+}
+
+/// @brief Appends `[fill][sign][prefix][zeros]digits[fill]` as laid out by
+/// `padding`, right-aligned by default.
+constexpr inline auto write_padded(Buffer& out, const char sign,
+                                   const ::std::string_view prefix,
+                                   const ::std::string_view digits,
+                                   const Padding& padding) -> void {
+  const auto size{digits.size() + prefix.size() + (sign not_eq 0 ? 1 : 0)};
+  const auto [before, zeros, after]{number_padding(padding, size)};
+  out.append(before, padding.fill_);
+  if (sign not_eq 0) {
+    out.push_back(sign);
+  }
+  out.append(prefix);
+  out.append(zeros, '0');
+  out.append(digits);
+  out.append(after, padding.fill_);
+}
+
+/// @brief Writes `[fill][sign][prefix][zeros]digits[fill]` straight into
+/// `out`, laid out by `padding`. `write_digits(char*)` produces exactly
+/// `digits` characters. Zero fill goes between the prefix and the digits.
+template <typename WriteDigits>
+constexpr inline auto write_integer(Buffer& out, const char sign,
+                                    const ::std::string_view prefix,
+                                    const ::std::size_t digits,
+                                    const Padding& padding,
+                                    WriteDigits write_digits) -> void {
+  const auto size{digits + prefix.size() + (sign not_eq 0 ? 1 : 0)};
+  const auto [before, zeros, after]{number_padding(padding, size)};
 
-  return result;
+  char* ptr{out.claim(before + size + zeros + after)};
+  if (ptr == nullptr) {
+    char scratch[64];
+    write_digits(scratch);
+    write_padded(out, sign, prefix, {scratch, digits}, padding);
+    return;
+  }
+
+  ptr = ::std::fill_n(ptr, before, padding.fill_);
+  if (sign not_eq 0) {
+    *ptr++ = sign;
+  }
+  ptr = ::std::copy(prefix.begin(), prefix.end(), ptr);
+  ptr = ::std::fill_n(ptr, zeros, '0');
+  write_digits(ptr);
+  ::std::fill_n(ptr + digits, after, padding.fill_);
+}
+
+/// @brief Columns `text` takes up, only worked out when there is a width to
+/// pad to. Never more than `text.size()`.
+constexpr inline auto text_columns(const ::std::string_view text,
+                                   const ::std::size_t width) noexcept
+    -> ::std::size_t {
+  return width == 0 ? text.size() : display_width(text);
+}
+
+/// @brief Appends `text` laid out by `padding`, left-aligned by default. The
+/// width counts display columns, so wide characters take two.
+constexpr inline auto write_text(Buffer& out, const ::std::string_view text,
+                                 const Padding& padding) -> void {
+  const auto [before, after]{split_padding(
+      padding, text_columns(text, padding.width_), Align::Left)};
+  if (char* ptr{out.claim(before + text.size() + after)}) {
+    ptr = ::std::fill_n(ptr, before, padding.fill_);
+    ptr = ::std::copy(text.begin(), text.end(), ptr);
+    ::std::fill_n(ptr, after, padding.fill_);
+    return;
+  }
+  out.append(before, padding.fill_);
+  out.append(text);
+  out.append(after, padding.fill_);
+}
+
+constexpr inline auto text_size(const ::std::string_view text,
+                                const ::std::size_t width) noexcept
+    -> ::std::size_t {
+  const auto columns{text_columns(text, width)};
+  return width > columns ? text.size() + (width - columns) : text.size();
 }
 
-inline constexpr ::std::string_view const OctalDigits{"01234567"};
+/// @brief Length of `n` in decimal, including the sign, padded to `width`.
 template <typename Type>
-inline auto to_octal(Type n, ::std::size_t len = 0ULL) -> ::std::string {
-  std::string result(len, '0');
-  for (size_t i = 0, j = (len - 1) * 4; i < len; ++i, j -= 4) {
-    result[i] = HexDigits[(n >> j) & 0x0f];
+constexpr inline auto decimal_size(const Type n, const ::std::size_t width = 0,
+                                   const Sign sign = Sign::Minus)
+    -> ::std::size_t {
+  return integer_size(sign_char(is_negative(n), sign), 0,
+                      count_digits(magnitude(n)), width);
+}
+
+/// @brief Writes `n` in decimal straight into `out`, laid out by `padding`.
+template <typename Type>
+constexpr inline auto to_decimal(Buffer& out, const Type n,
+                                 const Padding& padding = {},
+                                 const Sign sign = Sign::Minus) -> void {
+  const auto value{magnitude(n)};
+  const auto digits{count_digits(value)};
+  write_integer(out, sign_char(is_negative(n), sign), {}, digits, padding,
+                [&](char* ptr) { write_decimal(ptr, value, digits); });
+}
+
+/// @brief Stores a word of eight characters, whose lowest byte holds the
+/// least significant digit, so that the most significant digit comes first.
+constexpr inline auto store_digit_word(char* out, ::std::uint64_t word)
+    -> void {
+  if constexpr (::std::endian::native == ::std::endian::little) {
+    word = ::std::byteswap(word);
+  }
+  const auto bytes{::std::bit_cast<::std::array<char, 8>>(word)};
+  ::std::copy(bytes.begin(), bytes.end(), out);
+}
+
+/// @brief Eight hex digits of `n`, one per byte, using SWAR: the nibbles are
+/// spread into bytes, then every byte is offset to '0' and, where the nibble
+/// is above 9, on to 'a' or 'A'.
+constexpr inline auto hex_digit_word(const ::std::uint32_t n, const bool upper)
+    -> ::std::uint64_t {
+  ::std::uint64_t word{n};
+  word = ((word & 0xFFFF0000ULL) << 16) | (word & 0x0000FFFFULL);
+  word = ((word & 0x0000FF000000FF00ULL) << 8) |
+         (word & 0x000000FF000000FFULL);
+  word = ((word & 0x00F000F000F000F0ULL) << 4) |
+         (word & 0x000F000F000F000FULL);
+  const auto letters{((word + 0x0606060606060606ULL) >> 4) &
+                     0x0101010101010101ULL};
+  return word + 0x3030303030303030ULL + letters * (upper ? 7 : 39);
+}
+
+/// @brief Eight binary digits of the byte `n`, one per byte: the byte is
+/// broadcast, each lane keeps its own bit, and a carry turns it into 0 or 1.
+constexpr inline auto binary_digit_word(const ::std::uint8_t n)
+    -> ::std::uint64_t {
+  auto word{(n * 0x0101010101010101ULL) & 0x8040201008040201ULL};
+  word = ((word + 0x7F7F7F7F7F7F7F7FULL) & 0x8080808080808080ULL) >> 7;
+  return word + 0x3030303030303030ULL;
+}
+
+template <typename Unsigned>
+constexpr inline auto write_hex(char* const out, const Unsigned n,
+                                const ::std::size_t digits, const bool upper)
+    -> void {
+  char chars[16];
+  store_digit_word(chars + 8,
+                   hex_digit_word(static_cast<::std::uint32_t>(n), upper));
+  if constexpr (sizeof(Unsigned) > sizeof(::std::uint32_t)) {
+    store_digit_word(
+        chars, hex_digit_word(static_cast<::std::uint32_t>(n >> 32), upper));
+  }
+  ::std::copy_n(chars + sizeof(chars) - digits, digits, out);
+}
+
+template <typename Unsigned>
+constexpr inline auto write_binary(char* const out, const Unsigned n,
+                                   const ::std::size_t digits) -> void {
+  constexpr ::std::size_t Bytes{sizeof(Unsigned)};
+  char chars[Bytes * 8];
+  for (::std::size_t byte = 0; byte < (digits + 7) / 8; ++byte) {
+    store_digit_word(chars + (Bytes - 1 - byte) * 8,
+                     binary_digit_word(static_cast<::std::uint8_t>(
+                         n >> (byte * 8))));
   }
-  return result;
+  ::std::copy_n(chars + sizeof(chars) - digits, digits, out);
+}
+
+template <typename Unsigned>
+constexpr inline auto write_octal(char* const out, Unsigned n,
+                                  const ::std::size_t digits) -> void {
+  char* ptr{out + digits};
+  do {
+    *--ptr = static_cast<char>('0' + (n & 7));
+    n >>= 3;
+  } while (ptr not_eq out);
+}
+
+/// @brief Minimal number of digits of `n` in base `2^BitsPerDigit`.
+template <::std::size_t BitsPerDigit, typename Unsigned>
+constexpr inline auto count_radix_digits(const Unsigned n) noexcept
+    -> ::std::size_t {
+  const auto bits{static_cast<::std::size_t>(::std::bit_width(n | 1U))};
+  return (bits + BitsPerDigit - 1) / BitsPerDigit;
+}
+
+template <typename Type>
+constexpr inline auto hex_size(const Type n, const ::std::size_t width = 0,
+                               const Sign sign = Sign::Minus,
+                               const bool prefix = false) -> ::std::size_t {
+  return integer_size(sign_char(is_negative(n), sign), prefix ? 2 : 0,
+                      count_radix_digits<4>(magnitude(n)), width);
+}
+
+template <typename Type>
+constexpr inline auto octal_size(const Type n, const ::std::size_t width = 0,
+                                 const Sign sign = Sign::Minus,
+                                 const bool prefix = false) -> ::std::size_t {
+  return integer_size(sign_char(is_negative(n), sign),
+                      (prefix and n not_eq 0) ? 1 : 0,
+                      count_radix_digits<3>(magnitude(n)), width);
 }
 
 template <typename Type>
-inline auto to_binary(Type n, [[maybe_unused]] ::std::size_t len = 0ULL)
-    -> ::std::string {
-  auto bin{::std::bitset<sizeof(Type) * 8>(n).to_string()};
+constexpr inline auto binary_size(const Type n, const ::std::size_t width = 0,
+                                  const Sign sign = Sign::Minus,
+                                  const bool prefix = false) -> ::std::size_t {
+  return integer_size(sign_char(is_negative(n), sign), prefix ? 2 : 0,
+                      count_radix_digits<1>(magnitude(n)), width);
+}
 
-  ::std::size_t left{bin.find_first_of('1')};
-  if (left == ::std::string::npos) {
-    return bin;
-  } else if (len < bin.length() - left) {
-    return bin.substr(left);
+/// @brief Writes the minimal hex digits of `n` into `out`, with an optional
+/// `0x`/`0X` prefix, laid out by `padding`.
+template <typename Type>
+constexpr inline auto to_hex(Buffer& out, const Type n,
+                             const Padding& padding = {},
+                             const Sign sign = Sign::Minus,
+                             const bool upper = false,
+                             const bool prefix = false) -> void {
+  const auto value{magnitude(n)};
+  const auto digits{count_radix_digits<4>(value)};
+  const ::std::string_view base{upper ? "0X" : "0x"};
+  write_integer(out, sign_char(is_negative(n), sign), prefix ? base : "",
+                digits, padding,
+                [&](char* ptr) { write_hex(ptr, value, digits, upper); });
+}
+
+/// @brief Writes the minimal octal digits of `n` into `out`, with an optional
+/// leading `0`, laid out by `padding`.
+template <typename Type>
+constexpr inline auto to_octal(Buffer& out, const Type n,
+                               const Padding& padding = {},
+                               const Sign sign = Sign::Minus,
+                               const bool prefix = false) -> void {
+  const auto value{magnitude(n)};
+  const auto digits{count_radix_digits<3>(value)};
+  write_integer(out, sign_char(is_negative(n), sign),
+                (prefix and n not_eq 0) ? "0" : "", digits, padding,
+                [&](char* ptr) { write_octal(ptr, value, digits); });
+}
+
+/// @brief Writes the minimal binary digits of `n` into `out`, with an optional
+/// `0b`/`0B` prefix, laid out by `padding`.
+template <typename Type>
+constexpr inline auto to_binary(Buffer& out, const Type n,
+                                const Padding& padding = {},
+                                const Sign sign = Sign::Minus,
+                                const bool upper = false,
+                                const bool prefix = false) -> void {
+  const auto value{magnitude(n)};
+  const auto digits{count_radix_digits<1>(value)};
+  const ::std::string_view base{upper ? "0B" : "0b"};
+  write_integer(out, sign_char(is_negative(n), sign), prefix ? base : "",
+                digits, padding,
+                [&](char* ptr) { write_binary(ptr, value, digits); });
+}
+
+enum class FloatFormat {
+  /// @brief Shortest representation that parses back to the same value.
+  Shortest,
+  Fixed,
+  Scientific,
+  General,
+  /// @brief Hexadecimal mantissa and binary exponent, without a `0x` prefix.
+  Hex,
+};
+
+/// @brief Converts `n` into `scratch` and returns its length. Without a
+/// precision, each format gives the shortest round-trip digits; otherwise
+/// `precision` digits after the point (significant digits for `General`).
+/// Output does not depend on the locale.
+template <typename Type>
+inline auto float_chars(char* const scratch, const ::std::size_t size,
+                        const Type n, const FloatFormat format,
+                        const int precision) -> ::std::size_t {
+  char* const last{scratch + size};
+  ::std::to_chars_result result{};
+  if (format == FloatFormat::Shortest) {
+    result = precision < 0 ? ::std::to_chars(scratch, last, n)
+                           : ::std::to_chars(scratch, last, n,
+                                             ::std::chars_format::general,
+                                             precision);
+  } else {
+    const auto chars{format == FloatFormat::Fixed ? ::std::chars_format::fixed
+                     : format == FloatFormat::Scientific
+                         ? ::std::chars_format::scientific
+                     : format == FloatFormat::Hex
+                         ? ::std::chars_format::hex
+                         : ::std::chars_format::general};
+    result = precision < 0
+                 ? ::std::to_chars(scratch, last, n, chars)
+                 : ::std::to_chars(scratch, last, n, chars, precision);
+  }
+  if (result.ec not_eq ::std::errc{}) {
+    return 0;
   }
+  return static_cast<::std::size_t>(result.ptr - scratch);
+}
+
+/// @brief Upper bound on the length of `n`, enough for a fixed-format double
+/// of any exponent with the given precision.
+constexpr inline auto float_chars_bound(const int precision) noexcept
+    -> ::std::size_t {
+  return 352 + static_cast<::std::size_t>(precision < 0 ? 0 : precision);
+}
 
-  return bin;
+/// @brief Calls `use(chars, length)` with the characters of `n`, formatted on
+/// the stack unless an unusually large precision needs more room.
+template <typename Type, typename Use>
+inline auto with_float_chars(const Type n, const FloatFormat format,
+                             const int precision, const bool upper, Use use)
+    -> void {
+  char stack[384];
+  ::std::string heap{};
+  char* scratch{stack};
+  auto capacity{sizeof(stack)};
+  if (float_chars_bound(precision) > capacity) {
+    heap.resize(float_chars_bound(precision));
+    scratch = heap.data();
+    capacity = heap.size();
+  }
+  const auto length{float_chars(scratch, capacity, n, format, precision)};
+  if (upper) {
+    ::std::transform(scratch, scratch + length, scratch, [](const char c) {
+      return (c >= 'a' and c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    });
+  }
+  use(scratch, length);
+}
+
+/// @brief The characters of a float split where `#` forces a decimal point:
+/// `[sign]mantissa[.]exponent`.
+struct FloatText {
+  char sign_;
+  ::std::string_view mantissa_;
+  ::std::string_view exponent_;
+  bool point_;
+  bool finite_;
+
+  constexpr inline auto size() const noexcept -> ::std::size_t {
+    return (sign_ not_eq 0 ? 1 : 0) + mantissa_.size() + (point_ ? 1 : 0) +
+           exponent_.size();
+  }
+};
+
+constexpr inline auto float_text(const char* chars, ::std::size_t length,
+                                 const Sign sign, const bool alternate)
+    -> FloatText {
+  const bool negative{length not_eq 0 and chars[0] == '-'};
+  if (negative) {
+    ++chars;
+    --length;
+  }
+  const ::std::string_view text{chars, length};
+  const bool finite{length not_eq 0 and is_digit(text.front())};
+  const auto exponent{finite ? ::std::min(text.find_first_of("eEpP"),
+                                          text.size())
+                             : text.size()};
+  return FloatText{
+      .sign_ = sign_char(negative, sign),
+      .mantissa_ = text.substr(0, exponent),
+      .exponent_ = text.substr(exponent),
+      .point_ = alternate and finite and
+                text.substr(0, exponent).find('.') == text.npos,
+      .finite_ = finite,
+  };
 }
 
 template <typename Type>
-inline auto to_decimal(Type n, [[maybe_unused]] ::std::size_t len = 0ULL)
-    -> ::std::string {
-  return std::to_string(n);
+inline auto float_size(const Type n, const FloatFormat format,
+                       const int precision = -1, const ::std::size_t width = 0,
+                       const Sign sign = Sign::Minus,
+                       const bool alternate = false) -> ::std::size_t {
+  ::std::size_t size{0};
+  with_float_chars(n, format, precision, false,
+                   [&](const char* chars, const ::std::size_t length) {
+                     size = float_text(chars, length, sign, alternate).size();
+                   });
+  return width > size ? width : size;
 }
 
+/// @brief Writes `n` straight into `out`, laid out by `padding`. Zero fill
+/// goes after the sign, and is not used for infinity and NaN.
 template <typename Type>
-inline auto to_float(Type n, [[maybe_unused]] ::std::size_t len = 0ULL)
-    -> ::std::string {
-  return std::to_string(n);
+inline auto to_float(Buffer& out, const Type n,
+                     const FloatFormat format = FloatFormat::Shortest,
+                     const int precision = -1, const Padding& padding = {},
+                     const Sign sign = Sign::Minus, const bool upper = false,
+                     const bool alternate = false) -> void {
+  with_float_chars(
+      n, format, precision, upper,
+      [&](const char* chars, const ::std::size_t length) {
+        const auto text{float_text(chars, length, sign, alternate)};
+        Padding layout{padding};
+        layout.zero_ = padding.zero_ and text.finite_;
+        const auto [before, zeros, after]{number_padding(layout, text.size())};
+        out.append(before, layout.fill_);
+        if (text.sign_ not_eq 0) {
+          out.push_back(text.sign_);
+        }
+        out.append(zeros, '0');
+        out.append(text.mantissa_);
+        if (text.point_) {
+          out.push_back('.');
+        }
+        out.append(text.exponent_);
+        out.append(after, layout.fill_);
+      });
 }
 
 }  // namespace fmt::detail
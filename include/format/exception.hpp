@@ -2,11 +2,15 @@
 #define FORMAT_EXCEPTION_HPP_
 
 #include <stdexcept>
+
+#include "format/instrument.hpp"
+
 namespace fmt {
 class FormatError : public ::std::runtime_error {
   using ::std::runtime_error::runtime_error;
 };
 [[noreturn]] inline void _throw_format_error(const char* const what) {
+  detail::count(detail::Counter::Errors);
   throw FormatError(what);
 }
 }  // namespace fmt
@@ -2,206 +2,122 @@
 #define FORMAT_FORMAT_HPP_
 
 #include <array>
-#include <numeric>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
 #include <type_traits>
 
+#include "format/buffer.hpp"
+#include "format/concept.hpp"
+#include "format/config.hpp"
 #include "format/exception.hpp"
 #include "format/formatter.hpp"
+#include "format/named.hpp"
 #include "format/param.hpp"
 #include "format/specifier.hpp"
 
 namespace fmt {
 
-class BasicAppendable {
- public:
-  constexpr BasicAppendable() = default;
-  virtual ~BasicAppendable() = default;
-  virtual constexpr void append(::std::string& str,
-                                const FormatSpecifier& specifier) const = 0;
-  virtual void stream(std::ostream& os,
-                      const FormatSpecifier& specifier) const {
-    std::string str;
-    append(str, specifier);
-    os << str;
-  }
-};
-
-template <typename Type>
-constexpr inline auto buf_print(::std::string& str, const Type& val,
-                                const FormatSpecifier& specifiers) -> void {
-  Formatter<Type>::buf_print(str, val, specifiers);
-}
-template <typename Type>
-constexpr inline auto buf_print(::std::ostream& os, const Type& val,
-                                const FormatSpecifier& specifiers) -> void {
-  Formatter<Type>::buf_print(os, val, specifiers);
-}
-
-template <typename Type>
-concept BufPrint =
-    requires(std::string& str, Type val, const FormatSpecifier& specifier) {
-      buf_print(str, val, specifier);
-    };
-
-template <BufPrint Type>
-class Appendable;
-
-template <BufPrint Type>
-  requires(::std::is_trivially_copyable_v<Type>)
-class Appendable<Type> : public BasicAppendable {
- public:
-  constexpr explicit Appendable(const Type val) : val_(val) {}
-  constexpr Appendable() = default;
-  constexpr ~Appendable() override = default;
-  constexpr void append(
-      ::std::string& str,
-      [[maybe_unused]] const FormatSpecifier& specifier) const override {
-    buf_print(str, val_, specifier);
+/// @brief A literal span of the format string followed by one replacement
+/// field, whose specifier has already been parsed at compile time.
+struct FormatSegment {
+  /// @brief The specifier with its element specifier pointing into `fmt`,
+  /// the string this was parsed from, ready for a `Formatter`.
+  constexpr inline auto specifier(const ::std::string_view fmt) const noexcept
+      -> FormatSpecifier {
+    return specifier_.bind(fmt.data() + literal_offset_ + literal_size_ + 1);
   }
 
- private:
-  const Type val_;
+  ::fmt::u32 literal_offset_{0};
+  ::fmt::u32 literal_size_{0};
+  ::fmt::u32 position_{0};
+  FormatSpecifier specifier_{};
 };
 
-template <BufPrint Type>
-  requires(not ::std::is_trivially_copyable_v<Type>)
-class Appendable<Type> : public BasicAppendable {
- public:
-  constexpr explicit Appendable(const Type& val) : val_(&val) {}
-  constexpr Appendable() = default;
-  constexpr ~Appendable() override = default;
-  constexpr void append(
-      ::std::string& str,
-      [[maybe_unused]] const FormatSpecifier& specifier) const override {
-    buf_print(str, *val_, specifier);
-  }
-
- private:
-  const Type* val_;
+/// @brief A parsed format string without its argument types, which is all
+/// the formatting engine needs: every field, in order, and the text around
+/// them.
+struct FormatView {
+  ::std::string_view fmt_;
+  ::std::span<const FormatSegment> segments_;
+  ::std::size_t tail_offset_;
+  ::std::size_t literal_length_;
 };
 
-template <>
-class Appendable<const char*> : public BasicAppendable {
- public:
-  constexpr explicit Appendable(const char* val) : val_(val) {}
-  constexpr Appendable() = default;
-  constexpr ~Appendable() override = default;
-  constexpr void append(
-      ::std::string& str,
-      [[maybe_unused]] const FormatSpecifier& specifier) const override {
-    // str.append(val_);
-    buf_print(str, val_, specifier);
-  }
+namespace detail {
+
+/// @brief Walks the replacement fields of `fmt` in order, calling
+/// `visit(segment)` for each, and returns the offset of the literal text
+/// after the last one. `names` resolves `{name}` fields. Offsets count
+/// `Unit`s; the fields of wider strings are narrowed to be parsed.
+template <typename Unit, typename Visit>
+constexpr inline auto parse_segments(
+    const ::std::basic_string_view<Unit> fmt,
+    const ::std::span<const ::std::string_view> names, Visit visit)
+    -> ::std::size_t {
+  const Unit* const end{fmt.data() + fmt.size()};
+  ::std::size_t current{0};
+  ArgIndexer indexer{};
+  while (current < fmt.size()) {
+    const auto left{fmt.find(Unit{'{'}, current)};
+    if (left == fmt.npos) {
+      break;
+    }
+    const auto right{static_cast<::std::size_t>(
+        find_field_end(fmt.data() + left + 1, end) - fmt.data())};
+    if (right == fmt.size()) {
+      _throw_format_error("Missing closing brace");
+    }
 
- private:
-  const char* val_;
-};
-template <>
-class Appendable<::std::string> : public BasicAppendable {
- public:
-  constexpr explicit Appendable(const ::std::string& val) : val_(&val) {}
-  constexpr Appendable() = default;
-  constexpr ~Appendable() override = default;
-  constexpr void append(
-      ::std::string& str,
-      [[maybe_unused]] const FormatSpecifier& specifier) const override {
-    buf_print(str, *val_, specifier);
+    const auto text{fmt.substr(left + 1, right - left - 1)};
+    FormatField field{};
+    if constexpr (::std::is_same_v<Unit, char>) {
+      field = parse_field(text, indexer, names);
+    } else {
+      field = parse_field(narrow_field(text), indexer, names);
+    }
+    visit(FormatSegment{
+        .literal_offset_ = static_cast<::fmt::u32>(current),
+        .literal_size_ = static_cast<::fmt::u32>(left - current),
+        .position_ = static_cast<::fmt::u32>(field.position_),
+        .specifier_ = field.specifier_,
+    });
+    current = right + 1;
   }
-
- private:
-  const ::std::string* val_;
-};
-
-// template <BufPrint Type>
-//   requires(IsIntegerNoChar<Type>)
-// class Appendable<Type> : public BasicAppendable {
-//  public:
-//   constexpr explicit Appendable(Type val) : val_(val) {}
-//   constexpr Appendable() = default;
-//   constexpr ~Appendable() override = default;
-//   constexpr void append(
-//       ::std::string& str,
-//       [[maybe_unused]] const FormatSpecifier& specifier) const override {
-//     if (specifier.is_hex()) {
-//       if (specifier.has_size_) {
-//         str.append(detail::to_hex(val_, specifier.size_));
-//       } else {
-//         str.append(detail::to_hex(val_));
-//       }
-//     } else {
-//       str.append(::std::to_string(val_));
-//     }
-//   }
-
-//  private:
-//   Type val_;
-// };
-
-// template <BufPrint Type>
-//   requires(IsFloat<Type>)
-// class Appendable<Type> : public BasicAppendable {
-//  public:
-//   constexpr explicit Appendable(Type val) : val_(val) {}
-//   constexpr Appendable() = default;
-//   constexpr ~Appendable() override = default;
-//   constexpr void append(
-//       ::std::string& str,
-//       [[maybe_unused]] const FormatSpecifier& specifier) const override {
-//     buf_print(str, val_, specifier);
-//   }
-
-//  private:
-//   Type val_;
-// };
-
-template <typename Type>
-  requires(::std::is_trivially_copyable_v<Type>)
-constexpr inline auto make_appendable(const Type val) -> BasicAppendable* {
-  return new (::std::nothrow) Appendable<Type>(val);
-}
-template <typename Type>
-  requires(not ::std::is_trivially_copyable_v<Type>)
-constexpr inline auto make_appendable(const Type& val) -> BasicAppendable* {
-  return new (::std::nothrow) Appendable<Type>(val);
-}
-
-template <size_t Index = 0, typename... ArgsType>
-  requires(Index >= parameter_pack_arity<ArgsType...>())
-constexpr inline auto array_fill(
-    std::array<BasicAppendable*, parameter_pack_arity<ArgsType...>()>& arr,
-    const FormatArgs<const ArgsType*...>& args) noexcept -> void {}
-
-template <size_t Index = 0, typename... ArgsType>
-  requires(Index < parameter_pack_arity<ArgsType...>())
-constexpr inline auto array_fill(
-    std::array<BasicAppendable*, parameter_pack_arity<ArgsType...>()>& arr,
-    const FormatArgs<const ArgsType*...>& args) noexcept -> void {
-  arr[Index] = make_appendable(*::std::get<Index>(args));
-  array_fill<Index + 1, ArgsType...>(arr, args);
+  return current;
 }
 
-template <typename... ArgsType>
-constexpr inline auto map_args(
-    const FormatArgs<const ArgsType*...>& format_args) noexcept
-    -> ::std::array<BasicAppendable*, parameter_pack_arity<ArgsType...>()> {
-  ::std::array<BasicAppendable*, parameter_pack_arity<ArgsType...>()> args{};
-
-  array_fill<0>(args, format_args);
-
-  return args;
-}
+}  // namespace detail
 
 template <typename MyChar, typename... ArgsType>
 class FormatStringImpl {
-  static constexpr auto Arity = parameter_pack_arity<ArgsType...>();
-  using ArgType = ::std::array<FormatSpecifier, Arity * 3>;
+ public:
+  static constexpr ::std::size_t Arity{sizeof...(ArgsType)};
+  /// @brief Fields beyond one per argument that the table has room for, for
+  /// strings that use an argument more than once.
+  static constexpr ::std::size_t SpareFields{8};
+  /// @brief Fields kept in the table. Every field is parsed once, here; a
+  /// string with more is rejected rather than parsed again on each call.
+  static constexpr ::std::size_t MaxFields{Arity == 0 ? 0
+                                                      : Arity + SpareFields};
+  /// @brief The name of each argument, empty for positional ones.
+  static constexpr ::std::array<::std::string_view, Arity> Names{
+      detail::NamedArgTraits<ArgsType>::Key...};
+
+ private:
+  using SegmentTable = ::std::array<FormatSegment, MaxFields>;
 
  public:
   template <class Type>
     requires ::std::convertible_to<const Type&,
                                    ::std::basic_string_view<MyChar>>
   consteval FormatStringImpl(const Type& fmt) : fmt_{fmt} {  // NOLINT
-    verify_arg_count();
+    verify_names();
+    compile();
   }
   constexpr FormatStringImpl() = default;
   constexpr ~FormatStringImpl() = default;
@@ -211,14 +127,31 @@ class FormatStringImpl {
     return fmt_;
   }
 
-  constexpr inline auto operator+=(const ::std::size_t offset) noexcept
-      -> FormatStringImpl& {
-    fmt_ = fmt_.substr(offset);
-    return *this;
+  /// @brief The replacement fields, in order, each with the literal text that
+  /// precedes it.
+  constexpr inline auto segments() const noexcept
+      -> ::std::span<const FormatSegment> {
+    return {segments_.data(), field_count_};
+  }
+  constexpr inline auto literal(const FormatSegment& segment) const noexcept
+      -> ::std::basic_string_view<MyChar> {
+    return {fmt_.data() + segment.literal_offset_, segment.literal_size_};
+  }
+  /// @brief Total length of all literal text, excluding replacement fields.
+  constexpr inline auto literal_length() const noexcept -> ::std::size_t {
+    return literal_length_;
+  }
+  /// @brief The literal text after the last replacement field.
+  constexpr inline auto tail() const noexcept
+      -> ::std::basic_string_view<MyChar> {
+    return fmt_.substr(tail_offset_);
   }
 
-  constexpr inline auto creep(const ::std::size_t offset) noexcept -> void {
-    fmt_ = fmt_.substr(offset);
+  /// @brief The parsed string, for the type-erased engine.
+  constexpr inline auto view() const noexcept -> FormatView
+    requires ::std::is_same_v<MyChar, char>
+  {
+    return {fmt_, segments(), tail_offset_, literal_length_};
   }
 
   constexpr inline auto length() const noexcept -> ::std::size_t {
@@ -260,154 +193,294 @@ class FormatStringImpl {
   operator ::std::basic_string_view<MyChar>() const noexcept { return fmt_; }
   // NOLINTEND
 
-  constexpr inline auto verify_arg_count() -> void {
-    ArgType args{};
-    [[maybe_unused]] auto count{count_format_args(args)};
-
-    auto max{::std::accumulate(
-        args.begin(), args.end(), 0ULL,
-        [](auto a, auto b) { return a > b.position_ ? a : b.position_; })};
-
-    if (count < Arity or max >= Arity) {
-      _throw_format_error("Too few arguments");
-    }
-
-    for (const auto& item : args) {
-      if (item.position_ > max or item.position_ >= Arity) {
-        _throw_format_error("Not enough arguments");
+ private:
+  /// @brief Names must be identifiers and unique within a call.
+  static constexpr inline auto verify_names() -> void {
+    for (::std::size_t i = 0; i < Arity; ++i) {
+      if (Names[i].empty()) {
+        continue;
       }
-    }
-    for (::std::size_t i = 0; i < max; ++i) {
-      bool found{false};
-      for (const auto& item : args) {
-        if (item.position_ == i) {
-          found = true;
-          break;
-        }
+      if (not detail::is_arg_name(Names[i])) {
+        _throw_format_error("Argument names must be identifiers");
       }
-      if (not found) {
-        _throw_format_error("All positions must be used.");
+      for (::std::size_t j = 0; j < i; ++j) {
+        if (Names[j] == Names[i]) {
+          _throw_format_error("Duplicate argument name");
+        }
       }
     }
   }
 
-  constexpr inline auto count_format_args(ArgType& args) -> ::std::size_t {
-    constexpr auto npos{::std::basic_string_view<MyChar>::npos};  // NOLINT
-
-    const MyChar* current{fmt_.data()};
-    const MyChar* const end{fmt_.data() + fmt_.length()};
-
-    ::std::size_t count{0};
-
-    while (current not_eq end) {
-      auto left{
-          ::std::basic_string_view<MyChar>{current, end}.find_first_of('{')};
-      if (left not_eq npos) {
-        auto right{
-            ::std::basic_string_view<MyChar>{current, end}.find_first_of('}')};
-        if (right == npos) {
-          _throw_format_error("Missing closing brace");
-        }
-        ::std::basic_string_view<MyChar> format_specifier_str{
-            current + left + 1, right - left - 1};
-        FormatSpecifier specifier{format_specifier_str};
-        if (not specifier.has_position_) {
-          specifier.position_ = count;
-          specifier.has_position_ = true;
-        }
-        args.at(count++) = specifier;
-
-        current += right + 1;
-      } else {
-        current = end;
+  /// @brief Splits the format string into literal spans and replacement
+  /// fields, parsing every specifier once so formatting only has to walk the
+  /// table. Every argument must be used, by a field or as a dynamic width or
+  /// precision, and every index must name an argument.
+  constexpr inline auto compile() -> void {
+    ::std::array<bool, Arity + 1> used{};
+    const auto use{[&](const ::std::size_t index) {
+      if (index >= Arity) {
+        _throw_format_error("Too few arguments");
+      }
+      used[index] = true;
+    }};
+
+    tail_offset_ = detail::parse_segments(
+        fmt_, Names, [&](const FormatSegment& segment) {
+          use(segment.position_);
+          if (segment.specifier_.has_dynamic_width()) {
+            use(segment.specifier_.width_);
+          }
+          if (segment.specifier_.has_dynamic_precision()) {
+            use(segment.specifier_.precision_);
+          }
+          literal_length_ += segment.literal_size_;
+          if (field_count_ == MaxFields) {
+            _throw_format_error(
+                "Too many fields for the arguments; use fmt::compile");
+          }
+          segments_[field_count_++] = segment;
+        });
+    literal_length_ += fmt_.length() - tail_offset_;
+
+    for (::std::size_t i = 0; i < Arity; ++i) {
+      if (not used[i]) {
+        _throw_format_error("All positions must be used.");
       }
     }
-    return count;
   }
 
- private:
   ::std::basic_string_view<MyChar> fmt_;
+  SegmentTable segments_{};
+  ::std::size_t field_count_{0};
+  ::std::size_t tail_offset_{0};
+  ::std::size_t literal_length_{0};
 };
 template <typename... ArgsType>
 using FormatString =
     FormatStringImpl<char, ::std::type_identity_t<ArgsType>...>;
 
-template <typename... ArgsType>
-class MappedArgs {
- public:
-  static constexpr auto Arity = parameter_pack_arity<ArgsType...>();
-  constexpr explicit MappedArgs(const FormatArgs<const ArgsType*...>& args)
-      : args_{map_args<ArgsType...>(args)} {}
-  constexpr MappedArgs() = default;
-  constexpr ~MappedArgs() {
-    for (auto& arg : args_) {
-      delete arg;
-    }
-  }
+namespace detail {
 
-  constexpr inline auto at(const ::std::size_t index) const noexcept
-      -> const BasicAppendable* const& {
-    return args_.at(index);
+/// @brief The formatting loop, shared by every argument list.
+constexpr inline auto format_segments(Buffer& out, const FormatView& fmt,
+                                      const ::std::span<const FormatArg> args)
+    -> void {
+  for (const auto& segment : fmt.segments_) {
+    out.append(fmt.fmt_.substr(segment.literal_offset_, segment.literal_size_));
+    format_field(out, args, segment.position_, segment.specifier(fmt.fmt_));
   }
-  constexpr inline auto at(const ::std::size_t index) noexcept
-      -> BasicAppendable*& {
-    return args_.at(index);
+  out.append(fmt.fmt_.substr(fmt.tail_offset_));
+}
+
+constexpr inline auto segments_size(const FormatView& fmt,
+                                    const ::std::span<const FormatArg> args)
+    -> ::std::size_t {
+  ::std::size_t size{fmt.literal_length_};
+  for (const auto& segment : fmt.segments_) {
+    size += field_size(args, segment.position_, segment.specifier(fmt.fmt_));
   }
+  return size;
+}
 
- private:
-  ::std::array<BasicAppendable*, Arity> args_;
-};
+/// @brief The runtime engine behind every compile-time checked call: one
+/// out-of-line copy, whatever the argument types.
+FORMAT_FUNC auto vformat_to(Buffer& out, const FormatView& fmt,
+                            ::std::span<const FormatArg> args) -> void;
+FORMAT_FUNC auto vformatted_size(const FormatView& fmt,
+                                 ::std::span<const FormatArg> args)
+    -> ::std::size_t;
+
+#if FORMAT_DEFINE_CORE
+FORMAT_FUNC auto vformat_to(Buffer& out, const FormatView& fmt,
+                            const ::std::span<const FormatArg> args) -> void {
+  const CallScope scope{out};
+  format_segments(out, fmt, args);
+}
 
+FORMAT_FUNC auto vformatted_size(const FormatView& fmt,
+                                 const ::std::span<const FormatArg> args)
+    -> ::std::size_t {
+  return segments_size(fmt, args);
+}
+#endif  // FORMAT_DEFINE_CORE
+
+}  // namespace detail
+
+/// @brief Packs nothing but the arguments; the work happens in the engine,
+/// or inline during constant evaluation.
 template <typename... ArgsType>
-constexpr inline auto _format_impl(FormatString<ArgsType...>& fmt_str,
-                                   MappedArgs<ArgsType...>& args,
-                                   ::std::string& out,
-                                   ::size_t index = 0) -> void {
-  ::std::string_view fmt{fmt_str};
-  while (not fmt.empty()) {
-    const auto left{fmt.find_first_of('{')};
-    if (left == ::std::string_view::npos) {
-      out.append(fmt);
-      return;
-    }
-    const auto right{fmt.find_first_of('}')};
-    if (right == ::std::string_view::npos) {
-      _throw_format_error("Missing closing brace");
-    }
-    const ::std::string_view format_specifier_str{
-        fmt.substr(left + 1, right - left - 1)};
-    FormatSpecifier specifier{format_specifier_str};
-    if (not specifier.has_position_) {
-      specifier.position_ = index;
-    }
-    out.append(fmt.substr(0, left));
-    args.at(specifier.position_)->append(out, specifier);
-    // fmt += right + 1;
-    fmt = fmt.substr(right + 1);
+constexpr inline auto _format_impl(const FormatString<ArgsType...>& fmt,
+                                   const FormatArgs<ArgsType...>& args,
+                                   Buffer& out) -> void {
+  if consteval {
+    detail::format_segments(out, fmt.view(), args.view());
+  } else {
+    detail::vformat_to(out, fmt.view(), args.view());
+  }
+}
 
-    ++index;
+template <typename... ArgsType>
+constexpr inline auto _formatted_size(const FormatString<ArgsType...>& fmt,
+                                      const FormatArgs<ArgsType...>& args)
+    -> ::std::size_t {
+  if consteval {
+    return detail::segments_size(fmt.view(), args.view());
+  } else {
+    return detail::vformatted_size(fmt.view(), args.view());
   }
+}
 
-  // _format_impl(fmt, args, out, index + 1);
+/// @brief The exact number of characters `format` would produce.
+template <typename... ArgsType>
+[[nodiscard]] constexpr auto formatted_size(FormatString<ArgsType...> fmt,
+                                            const ArgsType&... args_pack)
+    -> ::std::size_t {
+  const FormatArgs<ArgsType...> args{args_pack...};
+  return _formatted_size(fmt, args);
+}
+
+/// @brief Formats into a string in a single pass. With only integer and
+/// string arguments the string is sized exactly up front; otherwise sizing
+/// would format every argument twice, so the output is built in inline memory
+/// and copied over once.
+template <typename String, typename... ArgsType>
+constexpr inline auto _format_to_string(String& out,
+                                        const FormatString<ArgsType...>& fmt,
+                                        const FormatArgs<ArgsType...>& args)
+    -> void {
+  if constexpr ((detail::HasCheapSize<ArgsType> and ...)) {
+    detail::ContainerBuffer buf{out, _formatted_size(fmt, args)};
+    _format_impl(fmt, args, buf);
+  } else {
+    MemoryBuffer<> buf{};
+    _format_impl(fmt, args, buf);
+    out.append(buf.view());
+  }
 }
 
 template <typename... ArgsType>
 [[nodiscard]] constexpr auto format(FormatString<ArgsType...> fmt,
                                     const ArgsType&... args_pack)
     -> ::std::string {
-  const FormatArgs<const ArgsType*...> args{
-      ::std::forward<const ArgsType*>(&args_pack)...};
+  const FormatArgs<ArgsType...> args{args_pack...};
 
   ::std::string out{};
-  out.reserve(args.estimate_size() + fmt.length());
-
-  MappedArgs<ArgsType...> mapped_args{args};
+  _format_to_string(out, fmt, args);
+  return out;
+}
 
-  _format_impl(fmt, mapped_args, out);
+/// @brief Formats into a string that allocates through `allocator`, once;
+/// no other allocator is involved.
+template <typename Allocator, typename... ArgsType>
+[[nodiscard]] constexpr auto format(::std::allocator_arg_t,
+                                    const Allocator& allocator,
+                                    FormatString<ArgsType...> fmt,
+                                    const ArgsType&... args_pack)
+    -> ::std::basic_string<char, ::std::char_traits<char>, Allocator> {
+  const FormatArgs<ArgsType...> args{args_pack...};
 
+  ::std::basic_string<char, ::std::char_traits<char>, Allocator> out{
+      allocator};
+  _format_to_string(out, fmt, args);
   return out;
 }
 
+/// @brief Formats into a `std::pmr::string` backed by `resource`, e.g. a
+/// per-request `std::pmr::monotonic_buffer_resource`.
+template <typename... ArgsType>
+[[nodiscard]] auto format(::std::pmr::memory_resource* resource,
+                          FormatString<ArgsType...> fmt,
+                          const ArgsType&... args_pack) -> ::std::pmr::string {
+  return ::fmt::format(::std::allocator_arg,
+                       ::std::pmr::polymorphic_allocator<char>{resource}, fmt,
+                       args_pack...);
+}
+
+namespace detail {
+
+/// @brief Runs `write(Buffer&)` against the cheapest buffer for `OutputIt`
+/// and returns the iterator past the last character written.
+template <typename OutputIt, typename Write>
+constexpr inline auto write_to_iterator(OutputIt out, Write write)
+    -> OutputIt {
+  if constexpr (IsContiguousBackInserter<OutputIt>) {
+    ContainerBuffer buf{get_container(out)};
+    write(buf);
+    return out;
+  } else if constexpr (::std::is_same_v<OutputIt, char*>) {
+    FixedBuffer buf{out, ::std::numeric_limits<::std::size_t>::max()};
+    write(buf);
+    return out + buf.written();
+  } else {
+    IteratorBuffer<OutputIt> buf{out};
+    write(buf);
+    buf.flush();
+    return buf.out();
+  }
+}
+
+}  // namespace detail
+
+/// @brief Formats to an output iterator and returns the iterator past the
+/// last character written.
+template <typename OutputIt, typename... ArgsType>
+  requires ::std::output_iterator<OutputIt, const char&>
+constexpr auto format_to(OutputIt out, FormatString<ArgsType...> fmt,
+                         const ArgsType&... args_pack) -> OutputIt {
+  const FormatArgs<ArgsType...> args{args_pack...};
+  return detail::write_to_iterator(
+      out, [&](Buffer& buf) { _format_impl(fmt, args, buf); });
+}
+
+/// @brief Appends to any `Buffer`, such as a `MemoryBuffer`.
+template <typename... ArgsType>
+constexpr auto format_to(Buffer& out, FormatString<ArgsType...> fmt,
+                         const ArgsType&... args_pack) -> void {
+  const FormatArgs<ArgsType...> args{args_pack...};
+  _format_impl(fmt, args, out);
+}
+
+template <typename OutputIt>
+struct FormatToNResult {
+  OutputIt out_;
+  ::std::iter_difference_t<OutputIt> size_;
+};
+
+/// @brief Formats at most `n` characters to an output iterator. The returned
+/// size is the length the full output would have had.
+template <typename OutputIt, typename... ArgsType>
+  requires ::std::output_iterator<OutputIt, const char&>
+constexpr auto format_to_n(OutputIt out,
+                           const ::std::iter_difference_t<OutputIt> n,
+                           FormatString<ArgsType...> fmt,
+                           const ArgsType&... args_pack)
+    -> FormatToNResult<OutputIt> {
+  using Difference = ::std::iter_difference_t<OutputIt>;
+  const FormatArgs<ArgsType...> args{args_pack...};
+  const auto limit{static_cast<::std::size_t>(n > 0 ? n : 0)};
+
+  if constexpr (::std::is_same_v<OutputIt, char*>) {
+    detail::FixedBuffer buf{out, limit};
+    _format_impl(fmt, args, buf);
+    return {out + buf.written(), static_cast<Difference>(buf.count())};
+  } else {
+    detail::IteratorBuffer<OutputIt> buf{out, limit};
+    _format_impl(fmt, args, buf);
+    buf.flush();
+    return {buf.out(), static_cast<Difference>(buf.count())};
+  }
+}
+
+/// @brief Formats into caller-provided memory, truncating if it is too small.
+template <typename... ArgsType>
+constexpr auto format_into(::std::span<char> out,
+                           FormatString<ArgsType...> fmt,
+                           const ArgsType&... args_pack)
+    -> FormatToNResult<char*> {
+  return format_to_n(out.data(), static_cast<::std::ptrdiff_t>(out.size()),
+                     fmt, args_pack...);
+}
+
 }  // namespace fmt
 
 #endif  // FORMAT_FORMAT_HPP_
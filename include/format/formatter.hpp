@@ -1,10 +1,16 @@
 #ifndef FORMAT_FORMATTER_HPP_
 #define FORMAT_FORMATTER_HPP_
 
+#include <concepts>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 
+#include "format/buffer.hpp"
 #include "format/concept.hpp"
+#include "format/config.hpp"
+#include "format/named.hpp"
 #include "format/specifier.hpp"
 
 namespace fmt {
@@ -12,68 +18,330 @@ namespace fmt {
 template <typename Type>
 struct Formatter;
 
+/// @brief Strings are left-aligned in their width; a precision caps the
+/// number of columns written. Both count display columns of UTF-8 text.
 template <>
 struct Formatter<::std::string_view> {
-  static constexpr auto buf_print(::std::string& str,
-                                  const ::std::string_view val,
+  static constexpr auto buf_print(Buffer& str, const ::std::string_view val,
                                   const FormatSpecifier& specifiers) -> void {
-    (void)specifiers;
-    str.append(val);
+    detail::write_text(str, truncate(val, specifiers), specifiers.padding());
+  }
+  static constexpr auto size_hint(const ::std::string_view val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    return detail::text_size(truncate(val, specifiers), specifiers.width());
+  }
+
+ private:
+  static constexpr auto truncate(const ::std::string_view val,
+                                 const FormatSpecifier& specifiers)
+      -> ::std::string_view {
+    return specifiers.has_precision()
+               ? detail::truncate_to_width(val, specifiers.precision())
+               : val;
   }
 };
 template <>
 struct Formatter<const char*> {
-  static constexpr auto buf_print(::std::string& str, const char* const val,
+  static constexpr auto buf_print(Buffer& str, const char* const val,
                                   const FormatSpecifier& specifiers) -> void {
-    (void)specifiers;
-    str.append(val);
+    Formatter<::std::string_view>::buf_print(str, val, specifiers);
+  }
+  static constexpr auto size_hint(const char* const val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    return Formatter<::std::string_view>::size_hint(val, specifiers);
   }
 };
 template <>
 struct Formatter<::std::string> {
-  static constexpr auto buf_print(::std::string& str, const ::std::string& val,
+  static constexpr auto buf_print(Buffer& str, const ::std::string& val,
                                   const FormatSpecifier& specifiers) -> void {
-    (void)specifiers;
-    str.append(val);
+    Formatter<::std::string_view>::buf_print(str, val, specifiers);
+  }
+  static constexpr auto size_hint(const ::std::string& val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    return Formatter<::std::string_view>::size_hint(val, specifiers);
   }
 };
-template <IsIntegerNoChar Type>
-struct Formatter<Type> {
-  static constexpr auto buf_print(::std::string& str, Type val,
+namespace detail {
+
+/// @brief The integer formatter, a primary template so that each builtin
+/// type's copy has one linkable name and can be compiled into `format_core`.
+/// Constant evaluation runs the `constexpr` body inline; at runtime every
+/// call goes to the out-of-line `write` and `measure`.
+template <typename Type>
+struct IntegerFormatter {
+  static constexpr auto buf_print(Buffer& str, const Type val,
                                   const FormatSpecifier& specifiers) -> void {
-    auto size{specifiers.has_size_ ? specifiers.size_ : 0};
+    if consteval {
+      print(str, val, specifiers);
+    } else {
+      write(str, val, specifiers);
+    }
+  }
+  static constexpr auto size_hint(const Type val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    if consteval {
+      return size(val, specifiers);
+    } else {
+      return measure(val, specifiers);
+    }
+  }
+
+  static auto write(Buffer& str, Type val, const FormatSpecifier& specifiers)
+      -> void;
+  static auto measure(Type val, const FormatSpecifier& specifiers)
+      -> ::std::size_t;
+
+ private:
+  static constexpr auto print(Buffer& str, Type val,
+                              const FormatSpecifier& specifiers) -> void {
+    const auto padding{specifiers.padding()};
+    const auto sign{specifiers.sign()};
     if (specifiers.is_hex()) {
-      str.append(detail::to_hex(val, size));
+      to_hex(str, val, padding, sign, specifiers.is_upper(),
+             specifiers.is_alternate());
     } else if (specifiers.is_octal()) {
-      str.append(detail::to_octal(val, size));
+      to_octal(str, val, padding, sign, specifiers.is_alternate());
     } else if (specifiers.is_binary()) {
-      str.append(detail::to_binary(val, size));
+      to_binary(str, val, padding, sign, specifiers.is_upper(),
+                specifiers.is_alternate());
+    } else if (specifiers.is_char()) {
+      const char c{static_cast<char>(val)};
+      write_text(str, {&c, 1}, padding);
     } else {
-      str.append(detail::to_decimal(val, size));
+      to_decimal(str, val, padding, sign);
     }
   }
+  static constexpr auto size(Type val, const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    const auto width{specifiers.width()};
+    const auto sign{specifiers.sign()};
+    if (specifiers.is_hex()) {
+      return hex_size(val, width, sign, specifiers.is_alternate());
+    } else if (specifiers.is_octal()) {
+      return octal_size(val, width, sign, specifiers.is_alternate());
+    } else if (specifiers.is_binary()) {
+      return binary_size(val, width, sign, specifiers.is_alternate());
+    } else if (specifiers.is_char()) {
+      const char c{static_cast<char>(val)};
+      return text_size({&c, 1}, width);
+    }
+    return decimal_size(val, width, sign);
+  }
 };
-template <IsFloat Type>
-struct Formatter<Type> {
-  static constexpr auto buf_print(::std::string& str, Type val,
+
+/// @brief The float formatter, split the same way as `IntegerFormatter`.
+template <typename Type>
+struct FloatFormatter {
+  static constexpr auto buf_print(Buffer& str, const Type val,
                                   const FormatSpecifier& specifiers) -> void {
-    (void)specifiers;
-    str.append(detail::to_float(val));
+    if consteval {
+      print(str, val, specifiers);
+    } else {
+      write(str, val, specifiers);
+    }
+  }
+  static auto size_hint(Type val, const FormatSpecifier& specifiers)
+      -> ::std::size_t;
+
+  static auto write(Buffer& str, Type val, const FormatSpecifier& specifiers)
+      -> void;
+
+ private:
+  static constexpr auto print(Buffer& str, Type val,
+                              const FormatSpecifier& specifiers) -> void {
+    to_float(str, val, float_format(specifiers), precision(specifiers),
+             specifiers.padding(), specifiers.sign(), specifiers.is_upper(),
+             specifiers.is_alternate());
+  }
+  static constexpr auto float_format(const FormatSpecifier& specifiers)
+      -> FloatFormat {
+    if (specifiers.is_float()) {
+      return FloatFormat::Fixed;
+    } else if (specifiers.is_scientific()) {
+      return FloatFormat::Scientific;
+    } else if (specifiers.is_general()) {
+      return FloatFormat::General;
+    } else if (specifiers.is_hex_float()) {
+      return FloatFormat::Hex;
+    }
+    return FloatFormat::Shortest;
+  }
+  /// @brief An explicit type without a precision defaults to 6, as printf;
+  /// hex floats default to the shortest exact digits.
+  static constexpr auto precision(const FormatSpecifier& specifiers) -> int {
+    if (specifiers.has_precision()) {
+      return static_cast<int>(specifiers.precision());
+    }
+    const auto format{float_format(specifiers)};
+    return format == FloatFormat::Shortest or format == FloatFormat::Hex ? -1
+                                                                         : 6;
   }
 };
+
+#if FORMAT_DEFINE_CORE
+// Every integer and float type `Formatter` accepts is one of the widths
+// `format_core` instantiates, so consumers of the library only need the
+// declarations.
+template <typename Type>
+auto IntegerFormatter<Type>::write(Buffer& str, const Type val,
+                                   const FormatSpecifier& specifiers) -> void {
+  print(str, val, specifiers);
+}
+template <typename Type>
+auto IntegerFormatter<Type>::measure(const Type val,
+                                     const FormatSpecifier& specifiers)
+    -> ::std::size_t {
+  return size(val, specifiers);
+}
+
+template <typename Type>
+auto FloatFormatter<Type>::write(Buffer& str, const Type val,
+                                 const FormatSpecifier& specifiers) -> void {
+  print(str, val, specifiers);
+}
+template <typename Type>
+auto FloatFormatter<Type>::size_hint(const Type val,
+                                     const FormatSpecifier& specifiers)
+    -> ::std::size_t {
+  return float_size(val, float_format(specifiers), precision(specifiers),
+                    specifiers.width(), specifiers.sign(),
+                    specifiers.is_alternate());
+}
+#endif  // FORMAT_DEFINE_CORE
+
+}  // namespace detail
+
+template <IsIntegerNoChar Type>
+struct Formatter<Type> : detail::IntegerFormatter<Type> {};
+template <IsFloat Type>
+struct Formatter<Type> : detail::FloatFormatter<Type> {};
 template <>
 struct Formatter<char> {
-  static constexpr auto buf_print(::std::string& str, const char val,
+  static constexpr auto buf_print(Buffer& str, const char val,
                                   const FormatSpecifier& specifiers) -> void {
-    (void)specifiers;
     if (specifiers.is_char()) {
-      str.push_back(val);
+      detail::write_text(str, {&val, 1}, specifiers.padding());
     } else {
       Formatter<int>::buf_print(str, val, specifiers);
     }
   }
+  static constexpr auto size_hint(const char val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    if (specifiers.is_char()) {
+      return detail::text_size({&val, 1}, specifiers.width());
+    }
+    return Formatter<int>::size_hint(val, specifiers);
+  }
 };
 
+template <typename Type>
+constexpr inline auto buf_print(Buffer& str, const Type& val,
+                                const FormatSpecifier& specifiers) -> void {
+  Formatter<Type>::buf_print(str, val, specifiers);
+}
+
+/// @brief Formatters may provide `size_hint(val, specifier)` returning the
+/// exact number of characters `buf_print` will produce, so output can be sized
+/// without formatting twice.
+template <typename Type>
+concept HasSizeHint =
+    requires(const Type& val, const FormatSpecifier& specifier) {
+      {
+        Formatter<Type>::size_hint(val, specifier)
+      } -> ::std::convertible_to<::std::size_t>;
+    };
+
+template <typename Type>
+concept BufPrint =
+    requires(Buffer& str, const Type& val, const FormatSpecifier& specifier) {
+      Formatter<Type>::buf_print(str, val, specifier);
+    };
+
+/// @brief Types the library can format: strings of any spelling and anything
+/// with a `Formatter`. Qualifiers do not matter, so the `const` key of a map
+/// element is as formattable as the plain type.
+template <typename Type>
+concept IsFormattable = IsString<::std::remove_cvref_t<Type>> or
+                        BufPrint<::std::remove_cvref_t<Type>>;
+
+namespace detail {
+
+/// @brief Formats one argument through its own `Formatter`, with strings of
+/// any spelling going through `Formatter<std::string_view>` and named
+/// arguments unwrapped, as `FormatArgs` does.
+template <typename Type>
+constexpr inline auto write_arg(Buffer& out, const Type& val,
+                                const FormatSpecifier& specifier) -> void {
+  using Value = ::std::remove_cvref_t<Type>;
+  if constexpr (IsNamedArg<Value>) {
+    write_arg(out, val.value_, specifier);
+  } else if constexpr (IsString<Value>) {
+    Formatter<::std::string_view>::buf_print(out, ::std::string_view{val},
+                                             specifier);
+  } else {
+    static_assert(BufPrint<Value>, "No Formatter specialization for type");
+    Formatter<Value>::buf_print(out, val, specifier);
+  }
+}
+
+template <typename Type>
+constexpr inline auto arg_size(const Type& val,
+                               const FormatSpecifier& specifier)
+    -> ::std::size_t {
+  using Value = ::std::remove_cvref_t<Type>;
+  if constexpr (IsNamedArg<Value>) {
+    return arg_size(val.value_, specifier);
+  } else if constexpr (IsString<Value>) {
+    return Formatter<::std::string_view>::size_hint(::std::string_view{val},
+                                                    specifier);
+  } else if constexpr (HasSizeHint<Value>) {
+    return Formatter<Value>::size_hint(val, specifier);
+  } else {
+    FixedBuffer counter{nullptr, 0};
+    Formatter<Value>::buf_print(counter, val, specifier);
+    return counter.count();
+  }
+}
+
+/// @brief The value type behind an argument, named or not.
+template <typename Type>
+using ArgValue = ::std::remove_cvref_t<decltype(unwrap_named(
+    ::std::declval<const Type&>()))>;
+
+/// @brief Set for other types whose `size_hint` is cheap, see `HasCheapSize`.
+template <typename Type>
+inline constexpr bool HasCheapSizeHint{false};
+
+/// @brief Arguments whose `size_hint` is cheaper than formatting them:
+/// integers, strings and types that set `HasCheapSizeHint`. Sizing anything
+/// else, a float or a custom type, does most of the work of writing it.
+template <typename Type>
+concept HasCheapSize = IsInteger<ArgValue<Type>> or
+                       IsString<ArgValue<Type>> or
+                       HasCheapSizeHint<ArgValue<Type>>;
+
+}  // namespace detail
+
+#if not FORMAT_DEFINE_CORE
+// Instantiated once in format_core.
+namespace detail {
+extern template struct IntegerFormatter<::fmt::i16>;
+extern template struct IntegerFormatter<::fmt::i32>;
+extern template struct IntegerFormatter<::fmt::i64>;
+extern template struct IntegerFormatter<::fmt::u16>;
+extern template struct IntegerFormatter<::fmt::u32>;
+extern template struct IntegerFormatter<::fmt::u64>;
+extern template struct FloatFormatter<::fmt::f32>;
+extern template struct FloatFormatter<::fmt::f64>;
+}  // namespace detail
+#endif
+
 }  // namespace fmt
 
 #endif  // FORMAT_FORMATTER_HPP_
@@ -0,0 +1,248 @@
+#ifndef FORMAT_INSTRUMENT_HPP_
+#define FORMAT_INSTRUMENT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace fmt {
+
+/// @brief What the library did, as counted when it is built with
+/// `FORMAT_ENABLE_INSTRUMENTATION` defined. Without it every count is zero
+/// and the hooks compile to nothing. The macro must be the same in every
+/// translation unit.
+struct InstrumentationCounters {
+  /// @brief Formatting passes: one per `format`, `format_to`, `print`,
+  /// `vformat` call, or per element of `format_range_parallel`.
+  ::std::uint64_t calls_{0};
+  /// @brief Characters those passes produced.
+  ::std::uint64_t bytes_{0};
+  /// @brief Heap allocations made by the library's own buffers and strings.
+  ::std::uint64_t allocations_{0};
+  /// @brief Times a buffer had to grow while output was being written.
+  ::std::uint64_t regrowths_{0};
+  /// @brief Outputs that outgrew the size computed for them up front, which
+  /// means a `size_hint` under-reported.
+  ::std::uint64_t reserve_misses_{0};
+  /// @brief `FormatError`s thrown.
+  ::std::uint64_t errors_{0};
+};
+
+namespace detail {
+
+enum class Counter : ::std::size_t {
+  Calls,
+  Bytes,
+  Allocations,
+  Regrowths,
+  ReserveMisses,
+  Errors,
+};
+inline constexpr ::std::size_t CounterCount{6};
+
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+
+/// @brief One thread's counters. Only the owning thread writes them, with a
+/// plain load and store, so counting costs no atomic read-modify-write;
+/// other threads only read.
+struct CounterBlock {
+  auto add(const Counter counter, const ::std::uint64_t amount) noexcept
+      -> void {
+    auto& value{values_[static_cast<::std::size_t>(counter)]};
+    value.store(value.load(::std::memory_order_relaxed) + amount,
+                ::std::memory_order_relaxed);
+  }
+
+  auto read() const noexcept -> InstrumentationCounters {
+    const auto get{[&](const Counter counter) {
+      return values_[static_cast<::std::size_t>(counter)].load(
+          ::std::memory_order_relaxed);
+    }};
+    return {get(Counter::Calls),         get(Counter::Bytes),
+            get(Counter::Allocations),   get(Counter::Regrowths),
+            get(Counter::ReserveMisses), get(Counter::Errors)};
+  }
+
+  auto clear() noexcept -> void {
+    for (auto& value : values_) {
+      value.store(0, ::std::memory_order_relaxed);
+    }
+  }
+
+  ::std::array<::std::atomic<::std::uint64_t>, CounterCount> values_{};
+};
+
+inline auto operator+=(InstrumentationCounters& total,
+                       const InstrumentationCounters& more) noexcept
+    -> InstrumentationCounters& {
+  total.calls_ += more.calls_;
+  total.bytes_ += more.bytes_;
+  total.allocations_ += more.allocations_;
+  total.regrowths_ += more.regrowths_;
+  total.reserve_misses_ += more.reserve_misses_;
+  total.errors_ += more.errors_;
+  return total;
+}
+
+/// @brief Every live thread's counters, plus the sum of those of threads
+/// that have exited.
+class CounterRegistry {
+ public:
+  /// @brief Never destroyed, so threads and static destructors can still
+  /// count on their way out.
+  static auto instance() -> CounterRegistry& {
+    static CounterRegistry& registry{*new CounterRegistry{}};
+    return registry;
+  }
+
+  auto attach(CounterBlock* const block) -> void {
+    const ::std::lock_guard lock{mutex_};
+    live_.push_back(block);
+  }
+
+  auto detach(CounterBlock* const block) -> void {
+    const ::std::lock_guard lock{mutex_};
+    live_.erase(::std::remove(live_.begin(), live_.end(), block),
+                live_.end());
+    for (::std::size_t i = 0; i < CounterCount; ++i) {
+      retired_.add(static_cast<Counter>(i),
+                   block->values_[i].load(::std::memory_order_relaxed));
+    }
+  }
+
+  /// @brief Counts from a thread whose own counters are already gone.
+  auto add_retired(const Counter counter, const ::std::uint64_t amount)
+      -> void {
+    const ::std::lock_guard lock{mutex_};
+    retired_.add(counter, amount);
+  }
+
+  auto total() -> InstrumentationCounters {
+    const ::std::lock_guard lock{mutex_};
+    auto total{retired_.read()};
+    for (const auto* const block : live_) {
+      total += block->read();
+    }
+    return total;
+  }
+
+  auto clear() -> void {
+    const ::std::lock_guard lock{mutex_};
+    retired_.clear();
+    for (auto* const block : live_) {
+      block->clear();
+    }
+  }
+
+ private:
+  ::std::mutex mutex_{};
+  ::std::vector<CounterBlock*> live_{};
+  CounterBlock retired_{};
+};
+
+inline auto thread_finished() noexcept -> bool& {
+  thread_local bool finished{false};
+  return finished;
+}
+
+struct ThreadCounters : CounterBlock {
+  ThreadCounters() { CounterRegistry::instance().attach(this); }
+  ~ThreadCounters() {
+    CounterRegistry::instance().detach(this);
+    thread_finished() = true;
+  }
+  ThreadCounters(const ThreadCounters&) = delete;
+  auto operator=(const ThreadCounters&) -> ThreadCounters& = delete;
+};
+
+inline auto thread_counters() -> CounterBlock& {
+  thread_local ThreadCounters counters{};
+  return counters;
+}
+
+inline auto add_count(const Counter counter, const ::std::uint64_t amount)
+    -> void {
+  if (thread_finished()) {
+    CounterRegistry::instance().add_retired(counter, amount);
+  } else {
+    thread_counters().add(counter, amount);
+  }
+}
+
+#endif
+
+/// @brief Adds `amount` to one of the calling thread's counters. Does nothing
+/// during constant evaluation or without instrumentation.
+constexpr inline auto count(const Counter counter,
+                            const ::std::uint64_t amount = 1) -> void {
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+  if !consteval {
+    add_count(counter, amount);
+  }
+#else
+  (void)counter;
+  (void)amount;
+#endif
+}
+
+/// @brief Counts an allocation if a container's capacity went up.
+constexpr inline auto count_growth(const ::std::size_t before,
+                                   const ::std::size_t after) -> void {
+  if (after > before) {
+    count(Counter::Allocations);
+  }
+}
+
+}  // namespace detail
+
+namespace instrumentation {
+
+inline constexpr bool Enabled{
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+    true
+#else
+    false
+#endif
+};
+
+/// @brief The counters summed over every thread, including exited ones.
+inline auto snapshot() -> InstrumentationCounters {
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+  return detail::CounterRegistry::instance().total();
+#else
+  return {};
+#endif
+}
+
+/// @brief The calling thread's counters.
+inline auto thread_snapshot() -> InstrumentationCounters {
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+  if (detail::thread_finished()) {
+    return {};
+  }
+  return detail::thread_counters().read();
+#else
+  return {};
+#endif
+}
+
+/// @brief Zeroes every thread's counters. Counts made by other threads while
+/// this runs may survive it.
+inline auto reset() -> void {
+#if defined(FORMAT_ENABLE_INSTRUMENTATION)
+  detail::CounterRegistry::instance().clear();
+#endif
+}
+
+}  // namespace instrumentation
+
+}  // namespace fmt
+
+#endif  // FORMAT_INSTRUMENT_HPP_
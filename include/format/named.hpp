@@ -0,0 +1,126 @@
+#ifndef FORMAT_NAMED_HPP_
+#define FORMAT_NAMED_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+#include "format/exception.hpp"
+
+namespace fmt {
+
+/// @brief A string literal that can be passed as a template argument.
+template <::std::size_t Size>
+struct FixedString {
+  constexpr FixedString(const char (&str)[Size]) {  // NOLINT
+    ::std::copy_n(str, Size, data_);
+  }
+
+  constexpr inline auto view() const noexcept -> ::std::string_view {
+    return {data_, Size - 1};
+  }
+
+  char data_[Size]{};
+};
+
+/// @brief An argument referred to by name, `{user}`. The name is part of the
+/// type, so checking the format string maps it to an index and formatting
+/// only ever sees the value. Refers to the value, so it must not outlive it.
+template <FixedString Name, typename Type>
+struct NamedArg {
+  const Type& value_;
+};
+
+namespace detail {
+
+template <typename Type>
+struct NamedArgTraits {
+  static constexpr bool Named{false};
+  static constexpr ::std::string_view Key{};
+};
+
+template <FixedString Name, typename Type>
+struct NamedArgTraits<NamedArg<Name, Type>> {
+  static constexpr bool Named{true};
+  static constexpr ::std::string_view Key{Name.view()};
+};
+
+}  // namespace detail
+
+template <typename Type>
+concept IsNamedArg = detail::NamedArgTraits<Type>::Named;
+
+namespace detail {
+
+/// @brief The value behind a named argument, or the argument itself.
+template <typename Type>
+constexpr inline auto unwrap_named(const Type& arg) noexcept -> const auto& {
+  if constexpr (IsNamedArg<Type>) {
+    return arg.value_;
+  } else {
+    return arg;
+  }
+}
+
+/// @brief Names must look like identifiers, so they never read as an index.
+constexpr inline auto is_arg_name(const ::std::string_view name) noexcept
+    -> bool {
+  const auto is_start{[](const char c) {
+    return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or c == '_';
+  }};
+  if (name.empty() or not is_start(name.front())) {
+    return false;
+  }
+  return ::std::all_of(name.begin() + 1, name.end(), [&](const char c) {
+    return is_start(c) or (c >= '0' and c <= '9');
+  });
+}
+
+/// @brief The index of the argument called `name` in `names`, which holds
+/// one entry per argument, empty for unnamed ones.
+constexpr inline auto named_position(
+    const ::std::string_view name,
+    const ::std::span<const ::std::string_view> names) -> ::std::size_t {
+  for (::std::size_t i = 0; i < names.size(); ++i) {
+    if (names[i] == name) {
+      return i;
+    }
+  }
+  _throw_format_error("No argument with this name");
+}
+
+/// @brief The right-hand side of `"name"_a = value`.
+template <FixedString Name>
+struct ArgName {
+  template <typename Type>
+  constexpr inline auto operator=(const Type& value) const noexcept
+      -> NamedArg<Name, Type> {
+    return {value};
+  }
+};
+
+}  // namespace detail
+
+/// @brief Names an argument for `{name}` fields:
+/// `fmt::format("{user} took {ms}ms", fmt::arg<"user">(u), fmt::arg<"ms">(t))`.
+template <FixedString Name, typename Type>
+[[nodiscard]] constexpr auto arg(const Type& value) noexcept
+    -> NamedArg<Name, Type> {
+  return {value};
+}
+
+namespace literals {
+
+/// @brief `"user"_a = u` is `fmt::arg<"user">(u)`.
+template <FixedString Name>
+[[nodiscard]] consteval auto operator""_a() noexcept
+    -> detail::ArgName<Name> {
+  return {};
+}
+
+}  // namespace literals
+
+}  // namespace fmt
+
+#endif  // FORMAT_NAMED_HPP_
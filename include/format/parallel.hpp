@@ -0,0 +1,251 @@
+#ifndef FORMAT_PARALLEL_HPP_
+#define FORMAT_PARALLEL_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "format/buffer.hpp"
+#include "format/compile.hpp"
+#include "format/format.hpp"
+#include "format/param.hpp"
+
+namespace fmt {
+
+namespace detail {
+
+/// @brief Worker threads kept for the life of the process, so a parallel
+/// call costs a wake-up rather than thread creation. Runs one job at a time;
+/// the calling thread takes indices too.
+class ParallelPool {
+ public:
+  using Task = void (*)(const void* context, ::std::size_t index);
+
+  static auto instance() -> ParallelPool& {
+    static ParallelPool pool{};
+    return pool;
+  }
+
+  ParallelPool(const ParallelPool&) = delete;
+  auto operator=(const ParallelPool&) -> ParallelPool& = delete;
+  ~ParallelPool() {
+    {
+      const ::std::lock_guard lock{mutex_};
+      stopping_ = true;
+    }
+    work_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /// @brief Runs `task(context, index)` for every index below `count`,
+  /// starting workers up to `count - 1` if there are fewer. Returns once all
+  /// have finished. A single index, or a call while another job runs, e.g.
+  /// from inside one, runs on the calling thread alone.
+  auto run(const ::std::size_t count, const Task task,
+           const void* const context) -> void {
+    ::std::unique_lock job{job_mutex_, ::std::defer_lock};
+    if (count <= 1 or not job.try_lock()) {
+      for (::std::size_t index = 0; index < count; ++index) {
+        task(context, index);
+      }
+      return;
+    }
+
+    ::std::unique_lock lock{mutex_};
+    while (workers_.size() + 1 < count) {
+      workers_.emplace_back([this] { work(); });
+    }
+    task_ = task;
+    context_ = context;
+    count_ = count;
+    next_ = 0;
+    pending_ = count;
+    work_.notify_all();
+    take(lock);
+    done_.wait(lock, [&] { return pending_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  ParallelPool() = default;
+
+  /// @brief Runs indices of the current job until none are left. Called
+  /// with `mutex_` held, which is released around each task.
+  auto take(::std::unique_lock<::std::mutex>& lock) -> void {
+    while (task_ and next_ < count_) {
+      const auto task{task_};
+      const auto* const context{context_};
+      const auto index{next_++};
+      lock.unlock();
+      task(context, index);
+      lock.lock();
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  auto work() -> void {
+    ::std::unique_lock lock{mutex_};
+    while (true) {
+      work_.wait(lock, [&] {
+        return stopping_ or (task_ and next_ < count_);
+      });
+      if (stopping_) {
+        return;
+      }
+      take(lock);
+    }
+  }
+
+  ::std::mutex job_mutex_{};
+
+  ::std::mutex mutex_{};
+  ::std::condition_variable work_{};
+  ::std::condition_variable done_{};
+  Task task_{nullptr};
+  const void* context_{nullptr};
+  ::std::size_t count_{0};
+  ::std::size_t next_{0};
+  ::std::size_t pending_{0};
+  bool stopping_{false};
+  ::std::vector<::std::thread> workers_{};
+};
+
+/// @brief Runs `body(index)` for every index below `count` on the calling
+/// thread and the `ParallelPool`. Rethrows the first exception once all of
+/// them have finished.
+template <typename Body>
+auto parallel_for(const ::std::size_t count, Body body) -> void {
+  ::std::vector<::std::exception_ptr> errors(count);
+  const auto run{[&](const ::std::size_t index) {
+    try {
+      body(index);
+    } catch (...) {
+      errors[index] = ::std::current_exception();
+    }
+  }};
+  ParallelPool::instance().run(
+      count,
+      [](const void* const context, const ::std::size_t index) {
+        (*static_cast<decltype(&run)>(context))(index);
+      },
+      &run);
+  for (const auto& error : errors) {
+    if (error) {
+      ::std::rethrow_exception(error);
+    }
+  }
+}
+
+/// @brief Elements per chunk below which another thread does not pay off.
+inline constexpr ::std::size_t ParallelMinChunk{1024};
+/// @brief Output size below which the chunks are joined on one thread.
+inline constexpr ::std::size_t ParallelMinCopy{::std::size_t{1} << 22};
+
+/// @brief Formats `[0, count)` with `format_one(Buffer&, index)`,
+/// separating elements with `separator`. Each chunk of indices goes to its
+/// own string; the chunks are then copied to offsets given by a prefix sum
+/// of their sizes, so the result matches formatting them in order.
+template <typename FormatOne>
+auto format_parallel(const ::std::size_t count,
+                     const ::std::string_view separator,
+                     ::std::size_t threads, FormatOne format_one)
+    -> ::std::string {
+  if (threads == 0) {
+    threads = ::std::max(1U, ::std::thread::hardware_concurrency());
+  }
+  const auto chunks{::std::max<::std::size_t>(
+      1, ::std::min(threads, count / ParallelMinChunk))};
+  const auto bound{[&](const ::std::size_t chunk) {
+    return count / chunks * chunk + ::std::min(chunk, count % chunks);
+  }};
+
+  ::std::vector<::std::string> parts(chunks);
+  parallel_for(chunks, [&](const ::std::size_t chunk) {
+    ContainerBuffer buf{parts[chunk]};
+    const auto end{bound(chunk + 1)};
+    for (auto index{bound(chunk)}; index < end; ++index) {
+      if (index not_eq 0) {
+        buf.append(separator);
+      }
+      format_one(buf, index);
+    }
+  });
+
+  ::std::vector<::std::size_t> offsets(chunks + 1);
+  for (::std::size_t chunk = 0; chunk < chunks; ++chunk) {
+    offsets[chunk + 1] = offsets[chunk] + parts[chunk].size();
+  }
+
+  ::std::string out{};
+  out.resize_and_overwrite(
+      offsets[chunks],
+      [](char*, const ::std::size_t size) noexcept { return size; });
+  const auto copy{[&](const ::std::size_t chunk) {
+    ::std::ranges::copy(parts[chunk], out.data() + offsets[chunk]);
+  }};
+  if (offsets[chunks] < ParallelMinCopy) {
+    for (::std::size_t chunk = 0; chunk < chunks; ++chunk) {
+      copy(chunk);
+    }
+  } else {
+    parallel_for(chunks, copy);
+  }
+  return out;
+}
+
+}  // namespace detail
+
+/// @brief Formats every element of `range` with `fmt`, joined by
+/// `separator`, spreading the work over `threads` threads (the hardware
+/// concurrency if 0). The result is identical to formatting the elements
+/// one after another.
+template <::std::ranges::random_access_range Range>
+  requires ::std::ranges::sized_range<const Range>
+[[nodiscard]] auto format_range_parallel(
+    FormatString<::std::ranges::range_value_t<Range>> fmt,
+    const Range& range, const ::std::string_view separator,
+    const ::std::size_t threads = 0) -> ::std::string {
+  using Element = ::std::ranges::range_value_t<Range>;
+  const auto first{::std::ranges::begin(range)};
+  return detail::format_parallel(
+      ::std::ranges::size(range), separator, threads,
+      [&](Buffer& out, const ::std::size_t index) {
+        const auto& element{first[static_cast<::std::ptrdiff_t>(index)]};
+        const FormatArgs<Element> args{element};
+        _format_impl(fmt, args, out);
+      });
+}
+
+/// @brief As above, with a compiled format string.
+template <FixedString Fmt, ::std::ranges::random_access_range Range>
+  requires ::std::ranges::sized_range<const Range>
+[[nodiscard]] auto format_range_parallel(CompiledFormat<Fmt>,
+                                         const Range& range,
+                                         const ::std::string_view separator,
+                                         const ::std::size_t threads = 0)
+    -> ::std::string {
+  using Fields =
+      detail::CompiledFields<Fmt, ::std::ranges::range_value_t<Range>>;
+  const auto first{::std::ranges::begin(range)};
+  return detail::format_parallel(
+      ::std::ranges::size(range), separator, threads,
+      [&](Buffer& out, const ::std::size_t index) {
+        Fields::write(out, first[static_cast<::std::ptrdiff_t>(index)]);
+      });
+}
+
+}  // namespace fmt
+
+#endif  // FORMAT_PARALLEL_HPP_
@@ -1,112 +1,334 @@
 #ifndef FORMAT_PARAM_HPP_
 #define FORMAT_PARAM_HPP_
 
+#include <array>
 #include <cstddef>
+#include <limits>
+#include <span>
 #include <string>
-#include <tuple>
+#include <string_view>
+#include <type_traits>
+
+#include "format/buffer.hpp"
+#include "format/concept.hpp"
+#include "format/exception.hpp"
+#include "format/formatter.hpp"
+#include "format/named.hpp"
+#include "format/specifier.hpp"
 
 namespace fmt {
 
-template <typename, typename... Args>
-struct CountParameterPack {
-  static constexpr ::std::size_t Value{1 + CountParameterPack<Args...>::Value};
-};
+/// @brief A type-erased reference to one format argument. Builtin types are
+/// stored by value in a tagged union; anything else keeps a pointer to the
+/// argument plus the `Formatter<Type>` entry point for it, so capturing
+/// arguments never allocates and formatting never goes through a vtable.
+class FormatArg {
+ public:
+  enum class Kind : ::fmt::u8 {
+    None,
+    I32,
+    U32,
+    I64,
+    U64,
+    Char,
+    F32,
+    F64,
+    String,
+    Custom,
+  };
 
-template <typename Type>
-struct CountParameterPack<Type> {
-  static constexpr ::std::size_t Value{1};
-};
+  using CustomFormat = void (*)(Buffer&, const void*, const FormatSpecifier&);
+  using CustomSize = ::std::size_t (*)(const void*, const FormatSpecifier&);
 
-template <typename... Args>
-static constexpr inline auto parameter_pack_arity() {
-  return CountParameterPack<Args...>::Value;
-}
+  constexpr FormatArg() = default;
 
-template <typename T>
-struct FormatArgsEstimate {
-  static constexpr inline auto size([[maybe_unused]] const T& unused)
+  template <typename Type>
+  constexpr explicit FormatArg(const Type& val) noexcept {
+    if constexpr (::std::is_same_v<Type, char>) {
+      kind_ = Kind::Char;
+      value_.char_ = val;
+    } else if constexpr (IsSignedIntegerNoChar<Type>) {
+      if constexpr (sizeof(Type) <= sizeof(::fmt::i32)) {
+        kind_ = Kind::I32;
+        value_.i32_ = val;
+      } else {
+        kind_ = Kind::I64;
+        value_.i64_ = val;
+      }
+    } else if constexpr (IsUnsignedIntegerNoChar<Type>) {
+      if constexpr (sizeof(Type) <= sizeof(::fmt::u32)) {
+        kind_ = Kind::U32;
+        value_.u32_ = val;
+      } else {
+        kind_ = Kind::U64;
+        value_.u64_ = val;
+      }
+    } else if constexpr (::std::is_same_v<Type, ::fmt::f32>) {
+      kind_ = Kind::F32;
+      value_.f32_ = val;
+    } else if constexpr (::std::is_same_v<Type, ::fmt::f64>) {
+      kind_ = Kind::F64;
+      value_.f64_ = val;
+    } else if constexpr (IsString<Type>) {
+      kind_ = Kind::String;
+      value_.string_ = ::std::string_view{val};
+    } else {
+      static_assert(BufPrint<Type>, "No Formatter specialization for type");
+      kind_ = Kind::Custom;
+      value_.custom_ = Custom{&val, &format_custom<Type>, &size_custom<Type>};
+    }
+  }
+
+  constexpr inline auto kind() const noexcept -> Kind { return kind_; }
+
+  /// @brief The value of an argument used as a dynamic width or precision,
+  /// which must be a non-negative integer that fits in 16 bits.
+  constexpr inline auto dynamic_value() const -> ::fmt::u16 {
+    ::fmt::i64 value{-1};
+    switch (kind_) {
+      case Kind::I32: {
+        value = value_.i32_;
+        break;
+      }
+      case Kind::U32: {
+        value = value_.u32_;
+        break;
+      }
+      case Kind::I64: {
+        value = value_.i64_;
+        break;
+      }
+      case Kind::U64: {
+        value = value_.u64_ > ::std::numeric_limits<::fmt::u16>::max()
+                    ? ::std::numeric_limits<::fmt::i64>::max()
+                    : static_cast<::fmt::i64>(value_.u64_);
+        break;
+      }
+      default: {
+        _throw_format_error("Width or precision argument is not an integer");
+      }
+    }
+    if (value < 0 or value > ::std::numeric_limits<::fmt::u16>::max()) {
+      _throw_format_error("Width or precision argument is out of range");
+    }
+    return static_cast<::fmt::u16>(value);
+  }
+
+  /// @brief The number of characters `format` will write for `specifier`.
+  constexpr inline auto size(const FormatSpecifier& specifier) const
       -> ::std::size_t {
-    return 8;
+    switch (kind_) {
+      case Kind::None: {
+        return 0;
+      }
+      case Kind::I32: {
+        return Formatter<::fmt::i32>::size_hint(value_.i32_, specifier);
+      }
+      case Kind::U32: {
+        return Formatter<::fmt::u32>::size_hint(value_.u32_, specifier);
+      }
+      case Kind::I64: {
+        return Formatter<::fmt::i64>::size_hint(value_.i64_, specifier);
+      }
+      case Kind::U64: {
+        return Formatter<::fmt::u64>::size_hint(value_.u64_, specifier);
+      }
+      case Kind::Char: {
+        return Formatter<char>::size_hint(value_.char_, specifier);
+      }
+      case Kind::F32: {
+        return Formatter<::fmt::f32>::size_hint(value_.f32_, specifier);
+      }
+      case Kind::F64: {
+        return Formatter<::fmt::f64>::size_hint(value_.f64_, specifier);
+      }
+      case Kind::String: {
+        return Formatter<::std::string_view>::size_hint(value_.string_,
+                                                        specifier);
+      }
+      case Kind::Custom: {
+        return value_.custom_.size_(value_.custom_.value_, specifier);
+      }
+    }
+    return 0;
   }
-};
-template <>
-struct FormatArgsEstimate<::std::string> {
-  static constexpr inline auto size(const ::std::string& str) -> ::std::size_t {
-    return str.length();
+
+  constexpr inline auto format(Buffer& out,
+                               const FormatSpecifier& specifier) const
+      -> void {
+    switch (kind_) {
+      case Kind::None: {
+        break;
+      }
+      case Kind::I32: {
+        Formatter<::fmt::i32>::buf_print(out, value_.i32_, specifier);
+        break;
+      }
+      case Kind::U32: {
+        Formatter<::fmt::u32>::buf_print(out, value_.u32_, specifier);
+        break;
+      }
+      case Kind::I64: {
+        Formatter<::fmt::i64>::buf_print(out, value_.i64_, specifier);
+        break;
+      }
+      case Kind::U64: {
+        Formatter<::fmt::u64>::buf_print(out, value_.u64_, specifier);
+        break;
+      }
+      case Kind::Char: {
+        Formatter<char>::buf_print(out, value_.char_, specifier);
+        break;
+      }
+      case Kind::F32: {
+        Formatter<::fmt::f32>::buf_print(out, value_.f32_, specifier);
+        break;
+      }
+      case Kind::F64: {
+        Formatter<::fmt::f64>::buf_print(out, value_.f64_, specifier);
+        break;
+      }
+      case Kind::String: {
+        Formatter<::std::string_view>::buf_print(out, value_.string_,
+                                                 specifier);
+        break;
+      }
+      case Kind::Custom: {
+        value_.custom_.format_(out, value_.custom_.value_, specifier);
+        break;
+      }
+    }
   }
-};
-template <>
-struct FormatArgsEstimate<const char*> {
-  static constexpr inline auto size([[maybe_unused]] const char* str)
+
+ private:
+  template <typename Type>
+  static auto format_custom(Buffer& out, const void* val,
+                            const FormatSpecifier& specifier) -> void {
+    buf_print(out, *static_cast<const Type*>(val), specifier);
+  }
+
+  /// @brief Uses `Formatter<Type>::size_hint` when there is one, otherwise
+  /// formats into a buffer that only counts.
+  template <typename Type>
+  static auto size_custom(const void* val, const FormatSpecifier& specifier)
       -> ::std::size_t {
-    return 32UL;
+    const auto& value{*static_cast<const Type*>(val)};
+    if constexpr (HasSizeHint<Type>) {
+      return Formatter<Type>::size_hint(value, specifier);
+    } else {
+      detail::FixedBuffer counter{nullptr, 0};
+      buf_print(counter, value, specifier);
+      return counter.count();
+    }
   }
+
+  struct Custom {
+    const void* value_;
+    CustomFormat format_;
+    CustomSize size_;
+  };
+
+  union Value {
+    ::fmt::i32 i32_;
+    ::fmt::u32 u32_;
+    ::fmt::i64 i64_;
+    ::fmt::u64 u64_;
+    char char_;
+    ::fmt::f32 f32_;
+    ::fmt::f64 f64_;
+    ::std::string_view string_;
+    Custom custom_;
+  } value_{.u64_ = 0};
+  Kind kind_{Kind::None};
 };
 
-template <typename Type>
-constexpr inline auto estimate_size(const Type& t) -> ::std::size_t {
-  return FormatArgsEstimate<Type>::size(t);
-}
+/// @brief Stack-resident array of type-erased arguments for one call. Named
+/// arguments are stored as their values; the names were resolved when the
+/// format string was checked.
+template <typename... Args>
+class FormatArgs {
+ public:
+  static constexpr ::std::size_t Arity{sizeof...(Args)};
 
-template <size_t Index = 0, typename... Args>
-constexpr auto _impl_tuple_fold_size(const ::std::tuple<Args...>& t)
-    -> ::std::size_t;
+  constexpr explicit FormatArgs(const Args&... args)
+      : args_{FormatArg{detail::unwrap_named(args)}...} {}
 
-template <size_t Index = 0, typename... Args>
-  requires(Index >= parameter_pack_arity<Args...>())
-constexpr auto _impl_tuple_fold_size(
-    [[maybe_unused]] const ::std::tuple<Args...>& t) -> ::std::size_t {
-  return 0;
-}
-template <size_t Index = 0, typename... Args>
-  requires(Index < parameter_pack_arity<Args...>())
-constexpr auto _impl_tuple_fold_size(const ::std::tuple<Args...>& t)
-    -> ::std::size_t {
-  return estimate_size(::std::get<Index>(t)) +
-         ::fmt::_impl_tuple_fold_size<Index + 1, Args...>(t);
-}
+  constexpr inline auto at(const ::std::size_t index) const noexcept
+      -> const FormatArg& {
+    return args_[index];
+  }
+  constexpr inline auto operator[](const ::std::size_t index) const noexcept
+      -> const FormatArg& {
+    return args_[index];
+  }
+
+  /// @brief The arguments without their types, for the runtime engine.
+  constexpr inline auto view() const noexcept
+      -> ::std::span<const FormatArg> {
+    return {args_.data(), args_.size()};
+  }
 
+ private:
+  ::std::array<FormatArg, Arity> args_;
+};
+
+/// @brief Captures arguments for `vformat`. The result refers to the
+/// arguments, so it must not outlive them.
 template <typename... Args>
-constexpr auto tuple_fold_size(const ::std::tuple<Args...>& t)
-    -> ::std::size_t {
-  return ::fmt::_impl_tuple_fold_size<0, Args...>(t);
+[[nodiscard]] constexpr auto make_format_args(const Args&... args)
+    -> FormatArgs<Args...> {
+  return FormatArgs<Args...>{args...};
 }
 
-template <typename... Args>
-struct FormatArgs {
-  constexpr explicit FormatArgs(Args&&... args)
-      : args_{::std::make_tuple<Args...>(::std::forward<Args>(args)...)} {}
+namespace detail {
 
-  constexpr inline auto estimate_size() const noexcept -> ::std::size_t {
-    return ::fmt::tuple_fold_size<Args...>(args_);
+/// @brief `specifier` with a `{}` width or precision replaced by the value of
+/// the argument it refers to.
+constexpr inline auto resolve_dynamic(FormatSpecifier specifier,
+                                      const ::std::span<const FormatArg> args)
+    -> FormatSpecifier {
+  const auto lookup{[&](const ::std::size_t index) {
+    if (index >= args.size()) {
+      _throw_format_error("Argument index out of range");
+    }
+    return args[index].dynamic_value();
+  }};
+  if (specifier.dynamic_width_) {
+    specifier.width_ = lookup(specifier.width_);
+    specifier.dynamic_width_ = false;
   }
-
-  template <size_t Index>
-  constexpr auto get() const noexcept -> const
-      decltype(::std::get<Index>(::std::declval<::std::tuple<Args...>>()))& {
-    return ::std::get<Index>(args_);
+  if (specifier.dynamic_precision_) {
+    specifier.precision_ = lookup(specifier.precision_);
+    specifier.dynamic_precision_ = false;
   }
+  return specifier;
+}
 
-  template <size_t Index>
-  constexpr auto get() noexcept
-      -> decltype(::std::get<Index>(::std::declval<::std::tuple<Args...>>())) {
-    return ::std::get<Index>(args_);
+/// @brief Formats argument `position` into `out`, resolving a dynamic width
+/// or precision first.
+constexpr inline auto format_field(Buffer& out,
+                                   const ::std::span<const FormatArg> args,
+                                   const ::std::size_t position,
+                                   const FormatSpecifier& specifier) -> void {
+  if (specifier.is_dynamic()) [[unlikely]] {
+    args[position].format(out, resolve_dynamic(specifier, args));
+  } else {
+    args[position].format(out, specifier);
   }
+}
 
- private:
-  template <::std::size_t, typename... GetArgs>
-  friend constexpr auto ::std::get(const FormatArgs<GetArgs...>&);
+constexpr inline auto field_size(const ::std::span<const FormatArg> args,
+                                 const ::std::size_t position,
+                                 const FormatSpecifier& specifier)
+    -> ::std::size_t {
+  if (specifier.is_dynamic()) [[unlikely]] {
+    return args[position].size(resolve_dynamic(specifier, args));
+  }
+  return args[position].size(specifier);
+}
 
-  std::tuple<Args...> args_;
-};
+}  // namespace detail
 
 }  // namespace fmt
 
-namespace std {
-template <::std::size_t Index, typename... Args>
-constexpr auto get(const ::fmt::FormatArgs<Args...>& fmt) {
-  return ::std::get<Index>(fmt.args_);
-}
-}  // namespace std
-
 #endif  // FORMAT_PARAM_HPP_
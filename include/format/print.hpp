@@ -1,46 +1,397 @@
 #ifndef FORMAT_PRINT_HPP_
 #define FORMAT_PRINT_HPP_
 
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <memory>
 #include <ostream>
+#include <span>
+#include <streambuf>
+#include <system_error>
 
+#if __has_include(<sys/uio.h>) and __has_include(<unistd.h>)
+#include <sys/uio.h>
+#include <unistd.h>
+#define FORMAT_HAS_WRITEV 1
+#else
+#define FORMAT_HAS_WRITEV 0
+#endif
+
+#include "format/buffer.hpp"
+#include "format/config.hpp"
 #include "format/format.hpp"
+#include "format/instrument.hpp"
+#include "format/runtime.hpp"
 
 namespace fmt {
 
-template <typename... Args>
-auto print(std::ostream& os, const FormatString<Args...> fmt_str,
-           const Args&... raw_args) -> void {
-  ::std::string_view fmt{fmt_str};
-  size_t index{0};
+namespace detail {
+
+/// @brief Formats straight into a stream buffer's put area while it has room,
+/// then continues in a small inline array that is handed to `sputn` whenever
+/// it fills up. A line that fits is copied exactly once, with no allocation.
+class StreamBuffer final : public Buffer {
+ public:
+  explicit StreamBuffer(::std::streambuf& stream)
+      : Buffer{grow}, stream_{stream} {
+    char* const begin{PutArea::begin(stream_)};
+    const auto room{begin ? PutArea::end(stream_) - begin : 0};
+    if (room > 0 and room <= INT_MAX) {
+      set(begin, static_cast<::std::size_t>(room));
+    } else {
+      set(data_, sizeof(data_));
+    }
+  }
+
+  /// @brief Hands over whatever is still pending. Returns false if the
+  /// stream buffer did not accept all of it.
+  auto finish() -> bool {
+    commit();
+    return good_;
+  }
+
+ private:
+  /// @brief Reaches the protected put area of any `std::streambuf`.
+  struct PutArea : ::std::streambuf {
+    static auto begin(::std::streambuf& buf) -> char* {
+      return (buf.*&PutArea::pptr)();
+    }
+    static auto end(::std::streambuf& buf) -> char* {
+      return (buf.*&PutArea::epptr)();
+    }
+    static auto bump(::std::streambuf& buf, const int count) -> void {
+      (buf.*&PutArea::pbump)(count);
+    }
+  };
+
+  auto commit() -> void {
+    flushed(size_);
+    if (ptr_ == data_) {
+      const auto count{static_cast<::std::streamsize>(size_)};
+      good_ = good_ and stream_.sputn(data_, count) == count;
+    } else {
+      PutArea::bump(stream_, static_cast<int>(size_));
+    }
+    size_ = 0;
+  }
+
+  static auto grow(Buffer& buf, [[maybe_unused]] const ::std::size_t count)
+      -> void {
+    auto& self{static_cast<StreamBuffer&>(buf)};
+    self.commit();
+    self.set(self.data_, sizeof(self.data_));
+  }
+
+  ::std::streambuf& stream_;
+  bool good_{true};
+  char data_[512];
+};
+
+/// @brief Formats for a C stream into a stack buffer, handed to `fwrite`
+/// whenever it fills up. Holds the stream's lock while it lives, so a line
+/// is never interleaved with other threads' output, and writes with the
+/// unlocked `fwrite` where the C library has one. The stream's own buffering
+/// and flushing apply as usual.
+class FileBuffer final : public Buffer {
+ public:
+  explicit FileBuffer(::std::FILE* const file) : Buffer{grow}, file_{file} {
+#if defined(_WIN32)
+    ::_lock_file(file_);
+#else
+    ::flockfile(file_);
+#endif
+    set(data_, sizeof(data_));
+  }
+  ~FileBuffer() {
+#if defined(_WIN32)
+    ::_unlock_file(file_);
+#else
+    ::funlockfile(file_);
+#endif
+  }
+  FileBuffer(const FileBuffer&) = delete;
+  auto operator=(const FileBuffer&) -> FileBuffer& = delete;
+
+  /// @brief Hands over whatever is still pending. Returns false if the
+  /// stream did not accept all of it, with `errno` set.
+  auto finish() -> bool {
+    commit();
+    return good_;
+  }
+
+ private:
+  auto commit() -> void {
+    flushed(size_);
+#if defined(_WIN32)
+    const auto written{::_fwrite_nolock(data_, 1, size_, file_)};
+#elif defined(__GLIBC__)
+    const auto written{::fwrite_unlocked(data_, 1, size_, file_)};
+#else
+    const auto written{::std::fwrite(data_, 1, size_, file_)};
+#endif
+    good_ = good_ and written == size_;
+    size_ = 0;
+  }
+
+  static auto grow(Buffer& buf, [[maybe_unused]] const ::std::size_t count)
+      -> void {
+    auto& self{static_cast<FileBuffer&>(buf)};
+    self.commit();
+    self.set(self.data_, sizeof(self.data_));
+  }
+
+  ::std::FILE* file_;
+  bool good_{true};
+  char data_[512];
+};
+
+/// @brief One piece of output for a gathered write.
+struct OutputSpan {
+  const char* data_;
+  ::std::size_t size_;
+};
+
+/// @brief Receives the pieces of one formatted line.
+using SpanWriter = void (*)(void* context, const OutputSpan* spans,
+                            ::std::size_t count);
 
-  FormatArgs<const Args*...> fmt_args{
-      ::std::forward<const Args*>(&raw_args)...};
-  MappedArgs<Args...> args{fmt_args};
+/// @brief Formats every field into one scratch buffer, then calls
+/// `write(context, spans, count)` with the output as alternating spans:
+/// literal text pointing straight into the format string, and field text
+/// pointing into the scratch buffer. Empty spans are skipped.
+FORMAT_FUNC auto write_segments(const FormatView& fmt,
+                                ::std::span<const FormatArg> args,
+                                SpanWriter write, void* context) -> void;
 
-  while (not fmt.empty()) {
-    const auto left{fmt.find_first_of('{')};
-    if (left == ::std::string_view::npos) {
-      os << fmt;
-      return;
+#if FORMAT_HAS_WRITEV
+/// @brief Writes all spans to `fd`, up to 64 per `writev`, resuming after
+/// partial writes and `EINTR`.
+FORMAT_FUNC auto write_all(int fd, const OutputSpan* spans, ::std::size_t count)
+    -> void;
+#endif
+
+// The engines behind `fmt::print`, one out-of-line copy per destination.
+FORMAT_FUNC auto vprint(::std::ostream& os, const FormatView& fmt,
+                        ::std::span<const FormatArg> args) -> void;
+FORMAT_FUNC auto vprint(::std::ostream& os, RuntimeFormat fmt,
+                        ::std::span<const FormatArg> args) -> void;
+#if FORMAT_HAS_WRITEV
+FORMAT_FUNC auto vprint(int fd, const FormatView& fmt,
+                        ::std::span<const FormatArg> args) -> void;
+FORMAT_FUNC auto vprint(int fd, RuntimeFormat fmt,
+                        ::std::span<const FormatArg> args) -> void;
+#endif
+FORMAT_FUNC auto vprint(::std::FILE* file, const FormatView& fmt,
+                        ::std::span<const FormatArg> args) -> void;
+FORMAT_FUNC auto vprint(::std::FILE* file, RuntimeFormat fmt,
+                        ::std::span<const FormatArg> args) -> void;
+
+#if FORMAT_DEFINE_CORE
+FORMAT_FUNC auto write_segments(const FormatView& fmt,
+                                const ::std::span<const FormatArg> args,
+                                const SpanWriter write, void* const context)
+    -> void {
+  constexpr ::std::size_t InlineFields{32};
+  const auto fields{fmt.segments_};
+
+  // Lines with more fields than fit on the stack are rare enough to
+  // allocate for.
+  ::std::array<::std::size_t, InlineFields> inline_ends;
+  ::std::array<OutputSpan, InlineFields * 2 + 1> inline_spans;
+  ::std::unique_ptr<::std::size_t[]> heap_ends{};
+  ::std::unique_ptr<OutputSpan[]> heap_spans{};
+  ::std::size_t* ends{inline_ends.data()};
+  OutputSpan* spans{inline_spans.data()};
+  if (fields.size() > InlineFields) {
+    heap_ends = ::std::make_unique<::std::size_t[]>(fields.size());
+    heap_spans = ::std::make_unique<OutputSpan[]>(fields.size() * 2 + 1);
+    ends = heap_ends.get();
+    spans = heap_spans.get();
+  }
+
+  MemoryBuffer<512> scratch{};
+  for (::std::size_t i = 0; i < fields.size(); ++i) {
+    format_field(scratch, args, fields[i].position_,
+                 fields[i].specifier(fmt.fmt_));
+    ends[i] = scratch.size();
+  }
+
+  ::std::size_t count{0};
+  const auto add{[&](const char* data, const ::std::size_t size) {
+    if (size not_eq 0) {
+      spans[count++] = OutputSpan{data, size};
     }
-    const auto right{fmt.find_first_of('}')};
-    if (right == ::std::string_view::npos) {
-      _throw_format_error("Missing closing brace");
+  }};
+  ::std::size_t begin{0};
+  for (::std::size_t i = 0; i < fields.size(); ++i) {
+    add(fmt.fmt_.data() + fields[i].literal_offset_,
+        fields[i].literal_size_);
+    add(scratch.data() + begin, ends[i] - begin);
+    begin = ends[i];
+  }
+  add(fmt.fmt_.data() + fmt.tail_offset_, fmt.fmt_.size() - fmt.tail_offset_);
+  detail::count(Counter::Calls);
+  detail::count(Counter::Bytes, fmt.literal_length_ + scratch.size());
+
+  write(context, spans, count);
+}
+
+#if FORMAT_HAS_WRITEV
+FORMAT_FUNC auto write_all(const int fd, const OutputSpan* spans,
+                           ::std::size_t count) -> void {
+  ::std::array<::iovec, 64> iov{};
+  while (count not_eq 0) {
+    const auto batch{::std::min(count, iov.size())};
+    for (::std::size_t i = 0; i < batch; ++i) {
+      iov[i].iov_base = const_cast<char*>(spans[i].data_);  // NOLINT
+      iov[i].iov_len = spans[i].size_;
     }
-    const ::std::string_view format_specifier_str{
-        fmt.substr(left + 1, right - left - 1)};
-    FormatSpecifier specifier{format_specifier_str};
-    if (not specifier.has_position_) {
-      specifier.position_ = index;
+
+    ::std::size_t done{0};
+    while (done < batch) {
+      const auto written{
+          ::writev(fd, iov.data() + done, static_cast<int>(batch - done))};
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw ::std::system_error{errno, ::std::generic_category(), "writev"};
+      }
+      auto remaining{static_cast<::std::size_t>(written)};
+      while (done < batch and remaining >= iov[done].iov_len) {
+        remaining -= iov[done++].iov_len;
+      }
+      if (done < batch) {
+        auto* const base{static_cast<char*>(iov[done].iov_base)};
+        iov[done].iov_base = base + remaining;
+        iov[done].iov_len -= remaining;
+      }
     }
-    os << fmt.substr(0, left);
-    args.at(specifier.position_)->stream(os, specifier);
-    fmt = fmt.substr(right + 1);
+    spans += batch;
+    count -= batch;
+  }
+}
+#endif
+
+/// @brief Formats straight into the stream's buffer, see `StreamBuffer`.
+template <typename Write>
+auto print_to_stream(::std::ostream& os, Write write) -> void {
+  const ::std::ostream::sentry sentry{os};
+  if (not sentry) {
+    return;
+  }
+  StreamBuffer buf{*os.rdbuf()};
+  write(buf);
+  if (not buf.finish()) {
+    os.setstate(::std::ios_base::badbit);
+  }
+}
+
+FORMAT_FUNC auto vprint(::std::ostream& os, const FormatView& fmt,
+                        const ::std::span<const FormatArg> args) -> void {
+  print_to_stream(os, [&](Buffer& buf) { detail::vformat_to(buf, fmt, args); });
+}
+FORMAT_FUNC auto vprint(::std::ostream& os, const RuntimeFormat fmt,
+                        const ::std::span<const FormatArg> args) -> void {
+  print_to_stream(os, [&](Buffer& buf) { detail::vformat_to(buf, fmt, args); });
+}
 
-    ++index;
+#if FORMAT_HAS_WRITEV
+FORMAT_FUNC auto vprint(const int fd, const FormatView& fmt,
+                        const ::std::span<const FormatArg> args) -> void {
+  int target{fd};
+  write_segments(
+      fmt, args,
+      [](void* const context, const OutputSpan* spans,
+         const ::std::size_t count) {
+        write_all(*static_cast<const int*>(context), spans, count);
+      },
+      &target);
+}
+FORMAT_FUNC auto vprint(const int fd, const RuntimeFormat fmt,
+                        const ::std::span<const FormatArg> args) -> void {
+  MemoryBuffer<512> buf{};
+  detail::vformat_to(buf, fmt, args);
+  const OutputSpan span{buf.data(), buf.size()};
+  write_all(fd, &span, 1);
+}
+#endif
+
+/// @brief Formats under the stream's lock, then reports a failed write.
+template <typename Write>
+auto print_to_file(::std::FILE* const file, Write write) -> void {
+  FileBuffer buf{file};
+  write(buf);
+  if (not buf.finish()) {
+    throw ::std::system_error{errno, ::std::generic_category(), "fwrite"};
   }
 }
 
+FORMAT_FUNC auto vprint(::std::FILE* const file, const FormatView& fmt,
+                        const ::std::span<const FormatArg> args) -> void {
+  print_to_file(file, [&](Buffer& buf) { detail::vformat_to(buf, fmt, args); });
+}
+FORMAT_FUNC auto vprint(::std::FILE* const file, const RuntimeFormat fmt,
+                        const ::std::span<const FormatArg> args) -> void {
+  print_to_file(file, [&](Buffer& buf) { detail::vformat_to(buf, fmt, args); });
+}
+#endif  // FORMAT_DEFINE_CORE
+
+}  // namespace detail
+
+template <typename... Args>
+auto print(std::ostream& os, const FormatString<Args...> fmt,
+           const Args&... raw_args) -> void {
+  const FormatArgs<Args...> args{raw_args...};
+  detail::vprint(os, fmt.view(), args.view());
+}
+
+#if FORMAT_HAS_WRITEV
+/// @brief Prints to a file descriptor with a single gathered `writev`. Literal
+/// text is written from the format string itself; only fields are copied.
+/// Throws `std::system_error` if the write fails.
+template <typename... Args>
+auto print(const int fd, const FormatString<Args...> fmt,
+           const Args&... raw_args) -> void {
+  const FormatArgs<Args...> args{raw_args...};
+  detail::vprint(fd, fmt.view(), args.view());
+}
+#endif
+
+/// @brief Prints to a C stream through its own buffering, under the stream's
+/// lock, see `FileBuffer`. Throws `std::system_error` if the write fails.
+template <typename... Args>
+auto print(::std::FILE* file, const FormatString<Args...> fmt,
+           const Args&... raw_args) -> void {
+  const FormatArgs<Args...> args{raw_args...};
+  detail::vprint(file, fmt.view(), args.view());
+}
+
+template <typename... Args>
+auto print(std::ostream& os, const RuntimeFormat fmt, const Args&... raw_args)
+    -> void {
+  const FormatArgs<Args...> args{raw_args...};
+  detail::vprint(os, fmt, args.view());
+}
+
+#if FORMAT_HAS_WRITEV
+template <typename... Args>
+auto print(const int fd, const RuntimeFormat fmt, const Args&... raw_args)
+    -> void {
+  const FormatArgs<Args...> args{raw_args...};
+  detail::vprint(fd, fmt, args.view());
+}
+#endif
+
+template <typename... Args>
+auto print(::std::FILE* file, const RuntimeFormat fmt,
+           const Args&... raw_args) -> void {
+  const FormatArgs<Args...> args{raw_args...};
+  detail::vprint(file, fmt, args.view());
+}
+
 }  // namespace fmt
 
 #endif  // FORMAT_PRINT_HPP_
@@ -0,0 +1,605 @@
+#ifndef FORMAT_RANGES_HPP_
+#define FORMAT_RANGES_HPP_
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "format/buffer.hpp"
+#include "format/concept.hpp"
+#include "format/detail.hpp"
+#include "format/formatter.hpp"
+#include "format/specifier.hpp"
+
+namespace fmt {
+
+namespace detail {
+
+template <typename Range>
+using RangeElement =
+    ::std::remove_cvref_t<::std::ranges::range_reference_t<const Range>>;
+
+template <typename Type>
+concept IsMapLike = requires {
+  typename Type::key_type;
+  typename Type::mapped_type;
+};
+
+template <typename Type>
+concept IsSetLike = requires { typename Type::key_type; } and
+                    not IsMapLike<Type>;
+
+template <typename Type>
+concept IsFormattableRange =
+    ::std::ranges::input_range<const Type> and not IsString<Type> and
+    IsFormattable<RangeElement<Type>>;
+
+/// @brief Contiguous integers, which get a single exact-size write.
+template <typename Range>
+concept IsContiguousIntegers =
+    ::std::ranges::contiguous_range<const Range> and
+    ::std::ranges::sized_range<const Range> and
+    IsIntegerNoChar<RangeElement<Range>>;
+
+inline constexpr ::std::string_view RangeSeparator{", "};
+
+/// @brief Writes `[open]a, b, c[close]`, formatting every element with
+/// `element` straight into `out`.
+template <typename Range, typename WriteElement>
+constexpr inline auto write_sequence(Buffer& out, const Range& range,
+                                     const ::std::string_view open,
+                                     const ::std::string_view close,
+                                     WriteElement write_element) -> void {
+  out.append(open);
+  bool first{true};
+  for (const auto& item : range) {
+    if (not first) {
+      out.append(RangeSeparator);
+    }
+    first = false;
+    write_element(item);
+  }
+  out.append(close);
+}
+
+/// @brief Sizes the whole sequence first, claims it in one go, and writes
+/// each element into the claimed space. Plain decimal elements skip the
+/// `Buffer` entirely and go through the digit kernel.
+template <typename Integer>
+constexpr inline auto write_integers(Buffer& out,
+                                     const ::std::span<const Integer> items,
+                                     const FormatSpecifier& element) -> bool {
+  const bool plain{not element.has_width() and
+                   element.sign() == Sign::Minus and
+                   (element.type() == FormatSpecifier::Type::None or
+                    element.type() == FormatSpecifier::Type::Decimal)};
+
+  ::std::size_t size{items.empty() ? 0
+                                   : (items.size() - 1) *
+                                         RangeSeparator.size()};
+  for (const auto item : items) {
+    size += Formatter<Integer>::size_hint(item, element);
+  }
+  char* ptr{out.claim(size)};
+  if (ptr == nullptr) {
+    return false;
+  }
+
+  if (plain) {
+    for (::std::size_t i = 0; i < items.size(); ++i) {
+      if (i not_eq 0) {
+        ptr = ::std::copy(RangeSeparator.begin(), RangeSeparator.end(), ptr);
+      }
+      if (is_negative(items[i])) {
+        *ptr++ = '-';
+      }
+      const auto value{magnitude(items[i])};
+      const auto digits{count_digits(value)};
+      write_decimal(ptr, value, digits);
+      ptr += digits;
+    }
+  } else {
+    FixedBuffer fixed{ptr, size};
+    for (::std::size_t i = 0; i < items.size(); ++i) {
+      if (i not_eq 0) {
+        fixed.append(RangeSeparator);
+      }
+      Formatter<Integer>::buf_print(fixed, items[i], element);
+    }
+  }
+  return true;
+}
+
+/// @brief The letter after the backslash when `c` is escaped inside
+/// `quote`s, or 0 when it is written as is.
+constexpr inline auto escape_letter(const char c, const char quote) noexcept
+    -> char {
+  switch (c) {
+    case '\t': {
+      return 't';
+    }
+    case '\n': {
+      return 'n';
+    }
+    case '\r': {
+      return 'r';
+    }
+    case '\\': {
+      return '\\';
+    }
+    default: {
+      return c == quote ? c : 0;
+    }
+  }
+}
+
+/// @brief `c` quoted as `std::format` writes a `char` element, `'a'`, with
+/// quotes, backslashes and whitespace escaped. `text` holds the result.
+constexpr inline auto quote_char(const char c, char (&text)[4]) noexcept
+    -> ::std::string_view {
+  const char escape{escape_letter(c, '\'')};
+  ::std::size_t size{0};
+  text[size++] = '\'';
+  if (escape not_eq 0) {
+    text[size++] = '\\';
+    text[size++] = escape;
+  } else {
+    text[size++] = c;
+  }
+  text[size++] = '\'';
+  return {text, size};
+}
+
+/// @brief A string element as `std::format` writes it, `"a"`, escaped as
+/// `quote_char` does. A precision cuts the text before it is quoted; a width
+/// pads the quoted text, left-aligned.
+class QuotedString {
+ public:
+  constexpr QuotedString(const ::std::string_view text,
+                         const FormatSpecifier& element) noexcept
+      : text_{element.has_precision()
+                  ? truncate_to_width(text, element.precision())
+                  : text} {
+    for (const char c : text_) {
+      escapes_ += escape_letter(c, '"') not_eq 0 ? 1 : 0;
+    }
+  }
+
+  constexpr inline auto write(Buffer& out, const Padding& padding) const
+      -> void {
+    const auto [before, after]{
+        split_padding(padding, columns(padding.width_), Align::Left)};
+    out.append(before, padding.fill_);
+    out.push_back('"');
+    ::std::size_t run{0};
+    for (::std::size_t i = 0; i < text_.size(); ++i) {
+      if (const char escape{escape_letter(text_[i], '"')}; escape not_eq 0) {
+        out.append(text_.substr(run, i - run));
+        out.push_back('\\');
+        out.push_back(escape);
+        run = i + 1;
+      }
+    }
+    out.append(text_.substr(run));
+    out.push_back('"');
+    out.append(after, padding.fill_);
+  }
+
+  constexpr inline auto size(const ::std::size_t width) const noexcept
+      -> ::std::size_t {
+    const auto columns{this->columns(width)};
+    return text_.size() + escapes_ + 2 + (width > columns ? width - columns
+                                                          : 0);
+  }
+
+ private:
+  constexpr inline auto columns(const ::std::size_t width) const noexcept
+      -> ::std::size_t {
+    return text_columns(text_, width) + escapes_ + 2;
+  }
+
+  ::std::string_view text_;
+  ::std::size_t escapes_{0};
+};
+
+/// @brief Whether an element is a `char` or a string without a presentation
+/// type, which is written quoted, as `std::format` does.
+template <typename Type>
+constexpr inline auto is_quoted(const FormatSpecifier& element) noexcept
+    -> bool {
+  using Value = ::std::remove_cvref_t<Type>;
+  return (::std::is_same_v<Value, char> or IsString<Value>) and
+         element.type() == FormatSpecifier::Type::None;
+}
+
+/// @brief Writes one element of a range or tuple through its `Formatter`,
+/// except for quoted `char`s and strings, see `is_quoted`.
+template <typename Type>
+constexpr inline auto write_element(Buffer& out, const Type& val,
+                                    const FormatSpecifier& element) -> void {
+  using Value = ::std::remove_cvref_t<Type>;
+  if constexpr (::std::is_same_v<Value, char>) {
+    if (is_quoted<Type>(element)) {
+      char text[4];
+      write_text(out, quote_char(val, text), element.padding());
+      return;
+    }
+  } else if constexpr (IsString<Value>) {
+    if (is_quoted<Type>(element)) {
+      QuotedString{val, element}.write(out, element.padding());
+      return;
+    }
+  }
+  write_arg(out, val, element);
+}
+
+template <typename Type>
+constexpr inline auto element_size(const Type& val,
+                                   const FormatSpecifier& element)
+    -> ::std::size_t {
+  using Value = ::std::remove_cvref_t<Type>;
+  if constexpr (::std::is_same_v<Value, char>) {
+    if (is_quoted<Type>(element)) {
+      char text[4];
+      return text_size(quote_char(val, text), element.width());
+    }
+  } else if constexpr (IsString<Value>) {
+    if (is_quoted<Type>(element)) {
+      return QuotedString{val, element}.size(element.width());
+    }
+  }
+  return arg_size(val, element);
+}
+
+/// @brief Types whose every character written is ASCII, whatever the
+/// specifier, so their length is also their width in columns.
+template <typename Type>
+inline constexpr bool IsAsciiOutput{::std::is_arithmetic_v<Type>};
+template <typename... Types>
+inline constexpr bool IsAsciiOutput<::std::tuple<Types...>>{
+    (IsAsciiOutput<::std::remove_cv_t<Types>> and ...)};
+template <typename First, typename Second>
+inline constexpr bool IsAsciiOutput<::std::pair<First, Second>>{
+    IsAsciiOutput<::std::remove_cv_t<First>> and
+    IsAsciiOutput<::std::remove_cv_t<Second>>};
+template <typename Type>
+  requires IsFormattableRange<Type>
+inline constexpr bool IsAsciiOutput<Type>{IsAsciiOutput<RangeElement<Type>>};
+
+/// @brief Counts the display columns of what is written to it, a chunk at a
+/// time, without keeping the text.
+class ColumnCounter final : public Buffer {
+ public:
+  constexpr ColumnCounter() : Buffer{grow} { set(data_, sizeof(data_)); }
+
+  constexpr inline auto columns() -> ::std::size_t {
+    count(size_);
+    return columns_;
+  }
+
+ private:
+  static constexpr auto grow(Buffer& buf,
+                             [[maybe_unused]] const ::std::size_t count)
+      -> void {
+    auto& self{static_cast<ColumnCounter&>(buf)};
+    self.count(complete_utf8_size({self.data_, self.size_}));
+  }
+
+  constexpr inline auto count(const ::std::size_t size) -> void {
+    columns_ += display_width({data_, size});
+    ::std::copy(data_ + size, data_ + size_, data_);
+    size_ -= size;
+  }
+
+  char data_[64]{};
+  ::std::size_t columns_{0};
+};
+
+template <typename Type, typename Size, typename Write>
+constexpr inline auto output_columns(Size size, Write write)
+    -> ::std::size_t {
+  if constexpr (IsAsciiOutput<Type>) {
+    return size();
+  } else {
+    ColumnCounter counter{};
+    write(counter);
+    return counter.columns();
+  }
+}
+
+/// @brief Pads what `write(Buffer&)` writes to the field's width,
+/// left-aligned by default as strings are. The fill goes around output
+/// written straight to `out`: its width is its `size()` for ASCII-only
+/// `Type`s, and is otherwise counted by writing it once to a
+/// `ColumnCounter`.
+template <typename Type, typename Size, typename Write>
+constexpr inline auto write_padded_text(Buffer& out,
+                                        const FormatSpecifier& specifier,
+                                        Size size, Write write) -> void {
+  if (specifier.width() == 0) {
+    write(out);
+    return;
+  }
+  const auto padding{specifier.padding()};
+  const auto [before, after]{split_padding(
+      padding, output_columns<Type>(size, write), Align::Left)};
+  out.append(before, padding.fill_);
+  write(out);
+  out.append(after, padding.fill_);
+}
+
+template <typename Type, typename Size, typename Write>
+constexpr inline auto padded_text_size(const FormatSpecifier& specifier,
+                                       Size size, Write write)
+    -> ::std::size_t {
+  const ::std::size_t length{size()};
+  if (specifier.width() == 0) {
+    return length;
+  }
+  const auto columns{output_columns<Type>([&] { return length; }, write)};
+  return specifier.width() > columns ? length + (specifier.width() - columns)
+                                     : length;
+}
+
+template <typename Tuple, ::std::size_t... Index>
+constexpr inline auto write_tuple(Buffer& out, const Tuple& tuple,
+                                  const FormatSpecifier& specifier,
+                                  ::std::index_sequence<Index...>) -> void {
+  const FormatSpecifier element{specifier.nested()};
+  if (not specifier.is_unbracketed()) {
+    out.push_back('(');
+  }
+  ((Index == 0 ? void() : out.append(RangeSeparator),
+    write_element(out, ::std::get<Index>(tuple), element)),
+   ...);
+  if (not specifier.is_unbracketed()) {
+    out.push_back(')');
+  }
+}
+
+template <typename Tuple, ::std::size_t... Index>
+constexpr inline auto tuple_size(const Tuple& tuple,
+                                 const FormatSpecifier& specifier,
+                                 ::std::index_sequence<Index...>)
+    -> ::std::size_t {
+  const FormatSpecifier element{specifier.nested()};
+  constexpr ::std::size_t Separators{sizeof...(Index) == 0
+                                         ? 0
+                                         : sizeof...(Index) - 1};
+  return (specifier.is_unbracketed() ? 0 : 2) +
+         Separators * RangeSeparator.size() +
+         (element_size(::std::get<Index>(tuple), element) + ... + 0);
+}
+
+}  // namespace detail
+
+/// @brief Formats a range as `[a, b, c]`, a set as `{a, b, c}` and a map as
+/// `{k: v, ...}`. The element specifier follows a second colon, so `{::x}`
+/// writes every element in hex; `n` drops the brackets. A width pads the
+/// whole range. `char` and string elements are quoted and escaped, as
+/// `std::format` does, unless given a type such as `c` or `s`.
+template <typename Type>
+  requires detail::IsFormattableRange<Type>
+struct Formatter<Type> {
+  static constexpr auto buf_print(Buffer& str, const Type& val,
+                                  const FormatSpecifier& specifiers) -> void {
+    detail::write_padded_text<Type>(
+        str, specifiers, [&] { return size(val, specifiers); },
+        [&](Buffer& out) { write(out, val, specifiers); });
+  }
+  static constexpr auto size_hint(const Type& val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    return detail::padded_text_size<Type>(
+        specifiers, [&] { return size(val, specifiers); },
+        [&](Buffer& out) { write(out, val, specifiers); });
+  }
+
+ private:
+  static constexpr auto write(Buffer& str, const Type& val,
+                              const FormatSpecifier& specifiers) -> void {
+    const FormatSpecifier element{specifiers.nested()};
+    const auto [open, close]{brackets(specifiers)};
+
+    if constexpr (detail::IsContiguousIntegers<Type>) {
+      str.append(open);
+      const ::std::span items{::std::ranges::data(val),
+                              ::std::ranges::size(val)};
+      if (not detail::write_integers(str, items, element)) {
+        detail::write_sequence(str, items, {}, {}, [&](const auto item) {
+          detail::write_arg(str, item, element);
+        });
+      }
+      str.append(close);
+    } else if constexpr (detail::IsMapLike<Type>) {
+      detail::write_sequence(str, val, open, close, [&](const auto& item) {
+        detail::write_element(str, ::std::get<0>(item), element);
+        str.append(": ");
+        detail::write_element(str, ::std::get<1>(item), element);
+      });
+    } else {
+      detail::write_sequence(str, val, open, close, [&](const auto& item) {
+        detail::write_element(str, item, element);
+      });
+    }
+  }
+  static constexpr auto size(const Type& val,
+                             const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    const FormatSpecifier element{specifiers.nested()};
+    const auto [open, close]{brackets(specifiers)};
+
+    ::std::size_t size{open.size() + close.size()};
+    ::std::size_t count{0};
+    for (const auto& item : val) {
+      if constexpr (detail::IsMapLike<Type>) {
+        size += detail::element_size(::std::get<0>(item), element) + 2 +
+                detail::element_size(::std::get<1>(item), element);
+      } else {
+        size += detail::element_size(item, element);
+      }
+      ++count;
+    }
+    return size + (count == 0 ? 0 : (count - 1) * 2);
+  }
+  static constexpr auto brackets(const FormatSpecifier& specifiers)
+      -> ::std::pair<::std::string_view, ::std::string_view> {
+    if (specifiers.is_unbracketed()) {
+      return {};
+    } else if constexpr (detail::IsMapLike<Type> or detail::IsSetLike<Type>) {
+      return {"{", "}"};
+    }
+    return {"[", "]"};
+  }
+};
+
+/// @brief Formats as `(a, b, c)`, each member with the element specifier and
+/// the whole padded to the width.
+template <typename... Types>
+  requires(IsFormattable<Types> and ...)
+struct Formatter<::std::tuple<Types...>> {
+  static constexpr auto buf_print(Buffer& str,
+                                  const ::std::tuple<Types...>& val,
+                                  const FormatSpecifier& specifiers) -> void {
+    detail::write_padded_text<::std::tuple<Types...>>(
+        str, specifiers,
+        [&] { return detail::tuple_size(val, specifiers, Indices{}); },
+        [&](Buffer& out) {
+          detail::write_tuple(out, val, specifiers, Indices{});
+        });
+  }
+  static constexpr auto size_hint(const ::std::tuple<Types...>& val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    return detail::padded_text_size<::std::tuple<Types...>>(
+        specifiers,
+        [&] { return detail::tuple_size(val, specifiers, Indices{}); },
+        [&](Buffer& out) {
+          detail::write_tuple(out, val, specifiers, Indices{});
+        });
+  }
+
+ private:
+  using Indices = ::std::index_sequence_for<Types...>;
+};
+
+template <typename First, typename Second>
+  requires(IsFormattable<First> and IsFormattable<Second>)
+struct Formatter<::std::pair<First, Second>> {
+  static constexpr auto buf_print(Buffer& str,
+                                  const ::std::pair<First, Second>& val,
+                                  const FormatSpecifier& specifiers) -> void {
+    detail::write_padded_text<::std::pair<First, Second>>(
+        str, specifiers,
+        [&] { return detail::tuple_size(val, specifiers, Indices{}); },
+        [&](Buffer& out) {
+          detail::write_tuple(out, val, specifiers, Indices{});
+        });
+  }
+  static constexpr auto size_hint(const ::std::pair<First, Second>& val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    return detail::padded_text_size<::std::pair<First, Second>>(
+        specifiers,
+        [&] { return detail::tuple_size(val, specifiers, Indices{}); },
+        [&](Buffer& out) {
+          detail::write_tuple(out, val, specifiers, Indices{});
+        });
+  }
+
+ private:
+  using Indices = ::std::make_index_sequence<2>;
+};
+
+/// @brief Formats as `optional(value)` or `none`. The specifier applies to
+/// the value.
+template <typename Type>
+  requires IsFormattable<Type>
+struct Formatter<::std::optional<Type>> {
+  static constexpr auto buf_print(Buffer& str,
+                                  const ::std::optional<Type>& val,
+                                  const FormatSpecifier& specifiers) -> void {
+    if (not val) {
+      str.append("none");
+      return;
+    }
+    str.append("optional(");
+    detail::write_arg(str, *val, specifiers);
+    str.push_back(')');
+  }
+  static constexpr auto size_hint(const ::std::optional<Type>& val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t {
+    return val ? 10 + detail::arg_size(*val, specifiers) : 4;
+  }
+};
+
+/// @brief A range to be written with a separator of the caller's choosing,
+/// see `fmt::join`.
+template <typename Iterator, typename Sentinel>
+struct JoinView {
+  Iterator begin_;
+  Sentinel end_;
+  ::std::string_view separator_;
+};
+
+/// @brief `fmt::format("{:x}", fmt::join(values, " "))` writes every element
+/// with the field's specifier, separated by `separator`. The range must
+/// outlive the call.
+template <::std::ranges::input_range Range>
+  requires IsFormattable<detail::RangeElement<Range>>
+[[nodiscard]] constexpr auto join(const Range& range,
+                                  const ::std::string_view separator)
+    -> JoinView<::std::ranges::iterator_t<const Range>,
+                ::std::ranges::sentinel_t<const Range>> {
+  return {::std::ranges::begin(range), ::std::ranges::end(range), separator};
+}
+
+template <typename Iterator, typename Sentinel>
+struct Formatter<JoinView<Iterator, Sentinel>> {
+  static constexpr auto buf_print(Buffer& str,
+                                  const JoinView<Iterator, Sentinel>& val,
+                                  const FormatSpecifier& specifiers) -> void {
+    for (auto it{val.begin_}; it not_eq val.end_; ++it) {
+      if (it not_eq val.begin_) {
+        str.append(val.separator_);
+      }
+      detail::write_arg(str, *it, specifiers);
+    }
+  }
+  static constexpr auto size_hint(const JoinView<Iterator, Sentinel>& val,
+                                  const FormatSpecifier& specifiers)
+      -> ::std::size_t
+    requires ::std::forward_iterator<Iterator>
+  {
+    ::std::size_t size{0};
+    for (auto it{val.begin_}; it not_eq val.end_; ++it) {
+      if (it not_eq val.begin_) {
+        size += val.separator_.size();
+      }
+      size += detail::arg_size(*it, specifiers);
+    }
+    return size;
+  }
+};
+
+namespace detail {
+
+/// @brief A join of integers or strings is sized as cheaply as its elements.
+template <typename Iterator, typename Sentinel>
+  requires ::std::forward_iterator<Iterator>
+inline constexpr bool HasCheapSizeHint<JoinView<Iterator, Sentinel>>{
+    IsInteger<::std::iter_value_t<Iterator>> or
+    IsString<::std::iter_value_t<Iterator>>};
+
+}  // namespace detail
+
+}  // namespace fmt
+
+#endif  // FORMAT_RANGES_HPP_
@@ -0,0 +1,452 @@
+#ifndef FORMAT_RUNTIME_HPP_
+#define FORMAT_RUNTIME_HPP_
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "format/buffer.hpp"
+#include "format/config.hpp"
+#include "format/exception.hpp"
+#include "format/format.hpp"
+#include "format/param.hpp"
+#include "format/specifier.hpp"
+
+#if defined(__AVX2__) or FORMAT_HAS_SSE2
+#include <immintrin.h>
+#endif
+
+namespace fmt {
+
+class FormatCache;
+
+/// @brief A format string only known at runtime, e.g. loaded from a config
+/// file. It is validated while formatting and errors throw `FormatError`.
+/// With a `FormatCache`, it is parsed once and the parse is reused.
+class RuntimeFormat {
+ public:
+  constexpr explicit RuntimeFormat(const ::std::string_view fmt,
+                                   FormatCache* cache = nullptr) noexcept
+      : fmt_{fmt}, cache_{cache} {}
+
+  constexpr inline auto get() const noexcept -> ::std::string_view {
+    return fmt_;
+  }
+  constexpr inline auto cache() const noexcept -> FormatCache* {
+    return cache_;
+  }
+
+ private:
+  ::std::string_view fmt_;
+  FormatCache* cache_;
+};
+
+[[nodiscard]] constexpr inline auto runtime(const ::std::string_view fmt)
+    -> RuntimeFormat {
+  return RuntimeFormat{fmt};
+}
+[[nodiscard]] constexpr inline auto runtime(const ::std::string_view fmt,
+                                            FormatCache& cache)
+    -> RuntimeFormat {
+  return RuntimeFormat{fmt, &cache};
+}
+
+namespace detail {
+
+/// @brief Finds the first `c` in `[first, last)`, or `last`. Uses 32-byte
+/// AVX2 or 16-byte SSE2 compares when the target has them, see
+/// `FORMAT_HAS_SSE2`, which pays off on long, mostly literal templates.
+constexpr inline auto find_char(const char* first, const char* const last,
+                                const char c) -> const char* {
+  if !consteval {
+#if defined(__AVX2__)
+    const __m256i needle{_mm256_set1_epi8(c)};
+    while (last - first >= 32) {
+      const __m256i chunk{
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first))};
+      const auto mask{static_cast<unsigned>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)))};
+      if (mask not_eq 0) {
+        return first + ::std::countr_zero(mask);
+      }
+      first += 32;
+    }
+#endif
+#if FORMAT_HAS_SSE2
+    const __m128i small_needle{_mm_set1_epi8(c)};
+    while (last - first >= 16) {
+      const __m128i chunk{
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(first))};
+      const auto mask{static_cast<unsigned>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, small_needle)))};
+      if (mask not_eq 0) {
+        return first + ::std::countr_zero(mask);
+      }
+      first += 16;
+    }
+#endif
+  }
+  while (first not_eq last and *first not_eq c) {
+    ++first;
+  }
+  return first;
+}
+
+/// @brief Walks a runtime format string, calling `on_literal(string_view)`
+/// for the literal text before each replacement field and after the last
+/// one, which may be empty, and `on_field(FormatField, text)` for each field,
+/// with automatic positions already filled in and `text` what follows its
+/// `{`. Follows the same grammar as compile-time format strings.
+template <typename OnLiteral, typename OnField>
+constexpr inline auto parse_runtime(const ::std::string_view fmt,
+                                    OnLiteral on_literal, OnField on_field)
+    -> void {
+  const char* current{fmt.data()};
+  const char* const end{fmt.data() + fmt.size()};
+  ArgIndexer indexer{};
+
+  while (true) {
+    const char* const left{find_char(current, end, '{')};
+    on_literal(::std::string_view{current, static_cast<::std::size_t>(
+                                               left - current)});
+    if (left == end) {
+      break;
+    }
+    const char* right{find_char(left + 1, end, '}')};
+    if (find_char(left + 1, right, '{') not_eq right) {
+      right = find_field_end(left + 1, end);
+    }
+    if (right == end) {
+      _throw_format_error("Missing closing brace");
+    }
+
+    const ::std::string_view text{left + 1,
+                                  static_cast<::std::size_t>(right - left - 1)};
+    on_field(parse_field(text, indexer), text.data());
+    current = right + 1;
+  }
+}
+
+/// @brief Parses and formats in a single pass. Unused arguments are allowed,
+/// since a template may leave out fields.
+constexpr inline auto vformat_to(Buffer& out, const ::std::string_view fmt,
+                                 const ::std::span<const FormatArg> args)
+    -> void {
+  parse_runtime(
+      fmt, [&](const ::std::string_view literal) { out.append(literal); },
+      [&](const FormatField& field, const char* const text) {
+        if (field.position_ >= args.size()) {
+          _throw_format_error("Argument index out of range");
+        }
+        format_field(out, args, field.position_, field.specifier_.bind(text));
+      });
+}
+
+}  // namespace detail
+
+/// @brief A runtime format string parsed into the same segment table that
+/// compile-time strings use. It owns a copy of the string; the table only
+/// holds offsets into it, so copies and moves need no fixing up.
+class ParsedFormat {
+ public:
+  FORMAT_FUNC explicit ParsedFormat(::std::string_view fmt);
+
+  inline auto view() const noexcept -> ::std::string_view { return fmt_; }
+
+  /// @brief The number of arguments the string refers to.
+  inline auto arity() const noexcept -> ::std::size_t { return arity_; }
+
+  FORMAT_FUNC auto format(Buffer& out,
+                          ::std::span<const FormatArg> args) const -> void;
+
+ private:
+  /// @brief Grows the arity to cover argument `index`.
+  inline auto require(const ::std::size_t index) noexcept -> void {
+    if (index >= arity_) {
+      arity_ = index + 1;
+    }
+  }
+
+  inline auto offset_of(const ::std::string_view literal) const noexcept
+      -> ::fmt::u32 {
+    return static_cast<::fmt::u32>(literal.data() - fmt_.data());
+  }
+
+  ::std::string fmt_;
+  ::std::vector<FormatSegment> segments_{};
+  ::fmt::u32 tail_offset_{0};
+  ::std::size_t arity_{0};
+};
+
+/// @brief A bounded cache of parsed runtime format strings, shared between
+/// threads. Lookups hash the string and compare it against the cached copy,
+/// and never take a lock. Entries are inserted once with a compare-and-swap
+/// and kept for the cache's lifetime. Once a string's probe window is full,
+/// that string is parsed on every call and counted as a miss.
+class FormatCache {
+ public:
+  struct Stats {
+    ::fmt::u64 hits_;
+    ::fmt::u64 misses_;
+    ::std::size_t size_;
+    ::std::size_t capacity_;
+  };
+
+  /// @brief `capacity` is rounded up to a power of two.
+  explicit FormatCache(const ::std::size_t capacity = 64)
+      : capacity_{::std::bit_ceil(::std::max<::std::size_t>(capacity, 1))},
+        slots_{::std::make_unique<::std::atomic<const Entry*>[]>(capacity_)} {}
+  FormatCache(const FormatCache&) = delete;
+  auto operator=(const FormatCache&) -> FormatCache& = delete;
+  ~FormatCache() { clear(); }
+
+  /// @brief The parsed form of `fmt`, or `nullptr` if it is not cached and
+  /// there is no room for it. Throws `FormatError` if `fmt` is invalid.
+  FORMAT_FUNC auto find(::std::string_view fmt) -> const ParsedFormat*;
+
+  FORMAT_FUNC auto vformat_to(Buffer& out, ::std::string_view fmt,
+                              ::std::span<const FormatArg> args) -> void;
+
+  auto stats() const noexcept -> Stats {
+    Stats stats{0, 0, size_.load(::std::memory_order_relaxed), capacity_};
+    for (const auto& counters : counters_) {
+      stats.hits_ += counters.hits_.load(::std::memory_order_relaxed);
+      stats.misses_ += counters.misses_.load(::std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+  auto reset_stats() noexcept -> void {
+    for (auto& counters : counters_) {
+      counters.hits_.store(0, ::std::memory_order_relaxed);
+      counters.misses_.store(0, ::std::memory_order_relaxed);
+    }
+  }
+
+  /// @brief Drops every entry. Must not run concurrently with any other use
+  /// of the cache, or while a returned `ParsedFormat` is still in use.
+  auto clear() -> void {
+    for (::std::size_t i = 0; i < capacity_; ++i) {
+      delete slots_[i].exchange(nullptr, ::std::memory_order_acquire);
+    }
+    size_.store(0, ::std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr ::std::size_t MaxProbes{16};
+  static constexpr ::std::size_t Shards{16};
+
+  struct Entry {
+    Entry(const ::std::size_t hash, const ::std::string_view fmt)
+        : hash_{hash}, parsed_{fmt} {}
+
+    ::std::size_t hash_;
+    ParsedFormat parsed_;
+  };
+
+  /// @brief Counters are split across cache lines so that threads hitting
+  /// the same entry do not contend on one counter.
+  struct alignas(64) Counters {
+    ::std::atomic<::fmt::u64> hits_{0};
+    ::std::atomic<::fmt::u64> misses_{0};
+  };
+
+  static auto shard() -> ::std::size_t {
+    thread_local const ::std::size_t index{
+        ::std::hash<::std::thread::id>{}(::std::this_thread::get_id()) %
+        Shards};
+    return index;
+  }
+
+  ::std::size_t capacity_;
+  ::std::unique_ptr<::std::atomic<const Entry*>[]> slots_;
+  ::std::atomic<::std::size_t> size_{0};
+  ::std::array<Counters, Shards> counters_{};
+};
+
+namespace detail {
+
+FORMAT_FUNC auto vformat_to(Buffer& out, RuntimeFormat fmt,
+                            ::std::span<const FormatArg> args) -> void;
+
+}  // namespace detail
+
+[[nodiscard]] FORMAT_FUNC auto vformat(RuntimeFormat fmt,
+                                       ::std::span<const FormatArg> args)
+    -> ::std::string;
+[[nodiscard]] FORMAT_FUNC auto vformat(::std::string_view fmt,
+                                       ::std::span<const FormatArg> args)
+    -> ::std::string;
+
+FORMAT_FUNC auto vformat_to(Buffer& out, RuntimeFormat fmt,
+                            ::std::span<const FormatArg> args) -> void;
+FORMAT_FUNC auto vformat_to(Buffer& out, ::std::string_view fmt,
+                            ::std::span<const FormatArg> args) -> void;
+
+#if FORMAT_DEFINE_CORE
+
+FORMAT_FUNC ParsedFormat::ParsedFormat(const ::std::string_view fmt)
+    : fmt_{fmt} {
+  ::std::string_view literal{};
+  detail::parse_runtime(
+      fmt_, [&](const ::std::string_view text) { literal = text; },
+      [&](const FormatField& field, const char*) {
+        segments_.push_back(FormatSegment{
+            .literal_offset_ = offset_of(literal),
+            .literal_size_ = static_cast<::fmt::u32>(literal.size()),
+            .position_ = static_cast<::fmt::u32>(field.position_),
+            .specifier_ = field.specifier_,
+        });
+        require(field.position_);
+        if (field.specifier_.has_dynamic_width()) {
+          require(field.specifier_.width_);
+        }
+        if (field.specifier_.has_dynamic_precision()) {
+          require(field.specifier_.precision_);
+        }
+      });
+  tail_offset_ = offset_of(literal);
+}
+
+FORMAT_FUNC auto ParsedFormat::format(
+    Buffer& out, const ::std::span<const FormatArg> args) const -> void {
+  if (args.size() < arity_) {
+    _throw_format_error("Argument index out of range");
+  }
+  const ::std::string_view fmt{fmt_};
+  for (const auto& segment : segments_) {
+    out.append(fmt.substr(segment.literal_offset_, segment.literal_size_));
+    detail::format_field(out, args, segment.position_,
+                         segment.specifier(fmt));
+  }
+  out.append(fmt.substr(tail_offset_));
+}
+
+FORMAT_FUNC auto FormatCache::find(const ::std::string_view fmt)
+    -> const ParsedFormat* {
+  const auto hash{::std::hash<::std::string_view>{}(fmt)};
+  auto& counters{counters_[shard()]};
+  ::std::unique_ptr<Entry> fresh{};
+
+  const auto probes{::std::min(capacity_, MaxProbes)};
+  for (::std::size_t i = 0; i < probes; ++i) {
+    auto& slot{slots_[(hash + i) & (capacity_ - 1)]};
+    const Entry* entry{slot.load(::std::memory_order_acquire)};
+    if (entry == nullptr) {
+      if (not fresh) {
+        fresh = ::std::make_unique<Entry>(hash, fmt);
+      }
+      if (slot.compare_exchange_strong(entry, fresh.get(),
+                                       ::std::memory_order_acq_rel,
+                                       ::std::memory_order_acquire)) {
+        size_.fetch_add(1, ::std::memory_order_relaxed);
+        counters.misses_.fetch_add(1, ::std::memory_order_relaxed);
+        return &fresh.release()->parsed_;
+      }
+    }
+    if (entry->hash_ == hash and entry->parsed_.view() == fmt) {
+      counters.hits_.fetch_add(1, ::std::memory_order_relaxed);
+      return &entry->parsed_;
+    }
+  }
+  counters.misses_.fetch_add(1, ::std::memory_order_relaxed);
+  return nullptr;
+}
+
+FORMAT_FUNC auto FormatCache::vformat_to(
+    Buffer& out, const ::std::string_view fmt,
+    const ::std::span<const FormatArg> args) -> void {
+  if (const auto* parsed{find(fmt)}) {
+    parsed->format(out, args);
+  } else {
+    detail::vformat_to(out, fmt, args);
+  }
+}
+
+namespace detail {
+
+FORMAT_FUNC auto vformat_to(Buffer& out, const RuntimeFormat fmt,
+                            const ::std::span<const FormatArg> args) -> void {
+  const CallScope scope{out};
+  if (auto* const cache{fmt.cache()}) {
+    cache->vformat_to(out, fmt.get(), args);
+  } else {
+    detail::vformat_to(out, fmt.get(), args);
+  }
+}
+
+}  // namespace detail
+
+FORMAT_FUNC auto vformat(const RuntimeFormat fmt,
+                         const ::std::span<const FormatArg> args)
+    -> ::std::string {
+  MemoryBuffer<512> buf{};
+  detail::vformat_to(buf, fmt, args);
+  return buf.str();
+}
+FORMAT_FUNC auto vformat(const ::std::string_view fmt,
+                         const ::std::span<const FormatArg> args)
+    -> ::std::string {
+  return vformat(RuntimeFormat{fmt}, args);
+}
+
+FORMAT_FUNC auto vformat_to(Buffer& out, const RuntimeFormat fmt,
+                            const ::std::span<const FormatArg> args) -> void {
+  detail::vformat_to(out, fmt, args);
+}
+FORMAT_FUNC auto vformat_to(Buffer& out, const ::std::string_view fmt,
+                            const ::std::span<const FormatArg> args) -> void {
+  detail::vformat_to(out, RuntimeFormat{fmt}, args);
+}
+
+#endif  // FORMAT_DEFINE_CORE
+
+template <typename OutputIt>
+  requires ::std::output_iterator<OutputIt, const char&>
+auto vformat_to(OutputIt out, const RuntimeFormat fmt,
+                const ::std::span<const FormatArg> args) -> OutputIt {
+  return detail::write_to_iterator(
+      out, [&](Buffer& buf) { detail::vformat_to(buf, fmt, args); });
+}
+template <typename OutputIt>
+  requires ::std::output_iterator<OutputIt, const char&>
+auto vformat_to(OutputIt out, const ::std::string_view fmt,
+                const ::std::span<const FormatArg> args) -> OutputIt {
+  return vformat_to(out, RuntimeFormat{fmt}, args);
+}
+
+template <typename... ArgsType>
+[[nodiscard]] auto format(const RuntimeFormat fmt,
+                          const ArgsType&... args_pack) -> ::std::string {
+  const FormatArgs<ArgsType...> args{args_pack...};
+  return vformat(fmt, args.view());
+}
+
+template <typename... ArgsType>
+auto format_to(Buffer& out, const RuntimeFormat fmt,
+               const ArgsType&... args_pack) -> void {
+  const FormatArgs<ArgsType...> args{args_pack...};
+  detail::vformat_to(out, fmt, args.view());
+}
+
+template <typename OutputIt, typename... ArgsType>
+  requires ::std::output_iterator<OutputIt, const char&>
+auto format_to(OutputIt out, const RuntimeFormat fmt,
+               const ArgsType&... args_pack) -> OutputIt {
+  const FormatArgs<ArgsType...> args{args_pack...};
+  return vformat_to(out, fmt, args.view());
+}
+
+}  // namespace fmt
+
+#endif  // FORMAT_RUNTIME_HPP_
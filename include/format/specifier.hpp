@@ -2,42 +2,194 @@
 #define FORMAT_SPECIFIER_HPP_
 
 #include <cstddef>
+#include <limits>
+#include <span>
+#include <string>
 #include <string_view>
 
+#include "format/concept.hpp"
 #include "format/detail.hpp"
 #include "format/exception.hpp"
+#include "format/named.hpp"
 
 namespace fmt {
+
+namespace detail {
+
+/// @brief Hands out the argument indices of one format string: automatic
+/// `{}` ones in order, or explicit `{n}` ones, but not both, as in
+/// `std::format`. Named fields may be mixed with either.
+class ArgIndexer {
+ public:
+  constexpr inline auto automatic() -> ::std::size_t {
+    if (manual_) {
+      _throw_format_error(
+          "Cannot switch from manual to automatic argument indexing");
+    }
+    automatic_ = true;
+    return next_++;
+  }
+  constexpr inline auto manual(const ::std::size_t index) -> ::std::size_t {
+    if (automatic_) {
+      _throw_format_error(
+          "Cannot switch from automatic to manual argument indexing");
+    }
+    manual_ = true;
+    return index;
+  }
+
+ private:
+  ::std::size_t next_{0};
+  bool automatic_{false};
+  bool manual_{false};
+};
+
+}  // namespace detail
+
+/// @brief A parsed `[[fill]align][sign][#][0][width][.precision][type]`
+/// specifier, packed into 16 bytes so a table of them stays in cache. Width
+/// and precision written as `{}` or `{n}` hold the index of the argument
+/// that supplies them until the engine resolves it.
+///
+/// A specifier parsed from a field keeps its element specifier as an offset
+/// into the field's text, so tables of them can be copied freely; the engine
+/// `bind`s it to the text before handing it to a `Formatter`. One parsed
+/// from a string on its own refers to that string, as a `string_view` does.
 class FormatSpecifier {
  public:
-  static constexpr size_t HexMask{1 << 0}, OctalMask{1 << 1},
-      BinaryMask{1 << 2}, FloatMask{1 << 3}, CharMask{1 << 4},
-      PointerMask{1 << 5};
+  enum class Type : ::fmt::u8 {
+    None,
+    Decimal,
+    Hex,
+    Octal,
+    Binary,
+    Char,
+    Fixed,
+    Scientific,
+    General,
+    HexFloat,
+    String,
+    Pointer,
+    /// @brief `n`: a range or tuple without its surrounding brackets.
+    Unbracketed,
+  };
 
-  constexpr explicit FormatSpecifier(size_t position, size_t specifiers = 0ULL)
-      : position_{position}, specifiers_{specifiers} {}
+  /// @brief Parses the text after a field's `:`. Dynamic width and precision
+  /// are not allowed, since there are no arguments to take them from.
+  constexpr explicit FormatSpecifier(const ::std::string_view spec) {
+    parse(spec, nullptr);
+    *this = bind(spec.data());
+  }
 
-  constexpr explicit FormatSpecifier(const ::std::string_view fmt) {
-    parse_specifier(fmt);
+  /// @brief As above, for the specifier of a field, unbound. Dynamic width
+  /// and precision take their argument index from `indexer`, and `{name}`
+  /// ones are looked up in `names`.
+  constexpr FormatSpecifier(
+      const ::std::string_view spec, detail::ArgIndexer& indexer,
+      const ::std::span<const ::std::string_view> names = {}) {
+    parse(spec, &indexer, names);
   }
 
+  constexpr inline auto type() const noexcept -> Type {
+    return static_cast<Type>(type_);
+  }
   constexpr inline auto is_hex() const noexcept -> bool {
-    return specifiers_ & FormatSpecifier::HexMask;
+    return type() == Type::Hex;
   }
   constexpr inline auto is_octal() const noexcept -> bool {
-    return specifiers_ & FormatSpecifier::OctalMask;
+    return type() == Type::Octal;
   }
   constexpr inline auto is_binary() const noexcept -> bool {
-    return specifiers_ & FormatSpecifier::BinaryMask;
+    return type() == Type::Binary;
   }
+  /// @brief `f`: fixed notation.
   constexpr inline auto is_float() const noexcept -> bool {
-    return specifiers_ & FormatSpecifier::FloatMask;
+    return type() == Type::Fixed;
+  }
+  constexpr inline auto is_scientific() const noexcept -> bool {
+    return type() == Type::Scientific;
+  }
+  constexpr inline auto is_general() const noexcept -> bool {
+    return type() == Type::General;
+  }
+  constexpr inline auto is_hex_float() const noexcept -> bool {
+    return type() == Type::HexFloat;
   }
   constexpr inline auto is_char() const noexcept -> bool {
-    return specifiers_ & FormatSpecifier::CharMask;
+    return type() == Type::Char;
   }
   constexpr inline auto is_pointer() const noexcept -> bool {
-    return specifiers_ & FormatSpecifier::PointerMask;
+    return type() == Type::Pointer;
+  }
+  constexpr inline auto is_unbracketed() const noexcept -> bool {
+    return type() == Type::Unbracketed;
+  }
+  /// @brief Upper case digits and prefix, from `X`, `B`, `E`, `G` or `A`.
+  constexpr inline auto is_upper() const noexcept -> bool { return upper_; }
+  /// @brief `#`: prefix the number with its base (`0x`, `0b`, `0`), or keep
+  /// the decimal point of a float.
+  constexpr inline auto is_alternate() const noexcept -> bool {
+    return alternate_;
+  }
+  constexpr inline auto is_zero_padded() const noexcept -> bool {
+    return zero_;
+  }
+  constexpr inline auto align() const noexcept -> Align {
+    return static_cast<Align>(align_);
+  }
+  constexpr inline auto sign() const noexcept -> Sign {
+    return static_cast<Sign>(sign_);
+  }
+  constexpr inline auto fill() const noexcept -> char { return fill_; }
+
+  constexpr inline auto has_width() const noexcept -> bool {
+    return width_ not_eq 0 or dynamic_width_;
+  }
+  constexpr inline auto width() const noexcept -> ::std::size_t {
+    return width_;
+  }
+  constexpr inline auto has_precision() const noexcept -> bool {
+    return has_precision_;
+  }
+  constexpr inline auto precision() const noexcept -> ::std::size_t {
+    return precision_;
+  }
+  /// @brief Width or precision still refer to an argument.
+  constexpr inline auto is_dynamic() const noexcept -> bool {
+    return dynamic_width_ or dynamic_precision_;
+  }
+  constexpr inline auto has_dynamic_width() const noexcept -> bool {
+    return dynamic_width_;
+  }
+  constexpr inline auto has_dynamic_precision() const noexcept -> bool {
+    return dynamic_precision_;
+  }
+
+  /// @brief The layout the kernels pad to.
+  constexpr inline auto padding() const noexcept -> detail::Padding {
+    return {width_, fill_, align(), static_cast<bool>(zero_)};
+  }
+
+  /// @brief The specifier for the elements of a range, e.g. `x` in `{::x}`,
+  /// ready to be parsed by the range's formatter. Empty until bound.
+  constexpr inline auto nested() const noexcept -> ::std::string_view {
+    if (not bound_) {
+      return {};
+    }
+    return {nested_.text_, nested_size_};
+  }
+
+  /// @brief A copy whose element specifier points into `field`, the text
+  /// this was parsed from; for a field, what follows its `{`.
+  constexpr inline auto bind(const char* const field) const noexcept
+      -> FormatSpecifier {
+    if (bound_ or nested_size_ == 0) {
+      return *this;
+    }
+    FormatSpecifier bound{*this};
+    bound.nested_.text_ = field + nested_.offset_;
+    bound.bound_ = true;
+    return bound;
   }
 
   /// @brief Default constructor so an array can be created without needing to
@@ -46,156 +198,319 @@ class FormatSpecifier {
   constexpr ~FormatSpecifier() = default;
 
  private:
-  constexpr inline auto parse_specifier(const ::std::string_view fmt) -> void {
-    if (fmt.length() == 0) {
-      return;
-    }
-
-    enum class State {
-      Begin,
-      Position,
-      Fill,
-      SizeBegin,
-      Size,
-      End,
-    } state{State::Position};
-
-    const char* current{fmt.data()};
-    const char* const end{fmt.data() + fmt.length()};
-
-    const char* size_begin{nullptr};
-    const char* size_end{nullptr};
-    const char* position_end{nullptr};
-    char fill_intermediate{0};
-
-    while (current < end) {
-      switch (state) {
-        case State::Begin: {
-          if (*current == ':') {
-            state = State::Fill;
-          } else {
-            state = State::Position;
-          }
-        }
-        case State::Position: {
-          if (*current == ':') {
-            position_end = current;
-            state = State::Fill;
-          } else if (not detail::is_digit(*current)) {
-            _throw_format_error("Invalid character in the positional argument");
-          }
-          break;
-        }
-        case State::Fill: {
-          if (detail::is_alpha(*current)) {
-            fill_intermediate = *current;
-            state = State::SizeBegin;
-          } else if (*current == '0') {
-            fill_intermediate = *current;
-            state = State::SizeBegin;
-          } else if (detail::is_digit(*current)) {
-            size_begin = current;
-            state = State::Size;
-          } else {
-            _throw_format_error("Invalid character after ':'");
-          }
-          break;
-        }
-        case State::SizeBegin: {
-          size_begin = current;
-          state = State::Size;
-          break;
-        }
-        case State::Size: {
-          if (not detail::is_digit(*current)) {
-            size_end = current;
-            state = State::End;
-          }
-          break;
-        }
-        case State::End: {
-          throw ::std::runtime_error(
-              "Unexpected additional characters found in format specifier");
-        }
+  static constexpr inline auto is_align(const char c) noexcept -> bool {
+    return c == '<' or c == '>' or c == '^';
+  }
+  static constexpr inline auto to_align(const char c) noexcept -> Align {
+    return c == '<' ? Align::Left : c == '>' ? Align::Right : Align::Center;
+  }
+
+  constexpr inline auto parse(
+      ::std::string_view spec, detail::ArgIndexer* const indexer,
+      const ::std::span<const ::std::string_view> names = {}) -> void {
+    const char* const text{spec.data()};
+    // As for ranges in std::format, ':' is never a fill, so `{::>4}` always
+    // aligns the elements.
+    if (spec.size() >= 2 and spec[0] not_eq ':' and is_align(spec[1])) {
+      if (spec[0] == '{' or spec[0] == '}') {
+        _throw_format_error("Invalid fill character");
       }
+      fill_ = spec[0];
+      align_ = static_cast<::fmt::u8>(to_align(spec[1]));
+      spec.remove_prefix(2);
+    } else if (not spec.empty() and is_align(spec[0])) {
+      align_ = static_cast<::fmt::u8>(to_align(spec[0]));
+      spec.remove_prefix(1);
+    }
+
+    // A further ':' starts the element specifier, which is kept unparsed.
+    if (const auto colon{spec.find(':')}; colon not_eq spec.npos) {
+      const auto nested{spec.substr(colon + 1)};
+      if (nested.size() > MaxNestedSize) {
+        _throw_format_error("Element specifier is too long");
+      }
+      nested_.offset_ = static_cast<::fmt::u32>(nested.data() - text);
+      nested_size_ = static_cast<::fmt::u16>(nested.size());
+      spec = spec.substr(0, colon);
+    }
+
+    const char* current{spec.data()};
+    const char* const end{spec.data() + spec.size()};
+
+    if (current not_eq end and
+        (*current == '+' or *current == '-' or *current == ' ')) {
+      sign_ = static_cast<::fmt::u8>(*current == '+'   ? Sign::Plus
+                                     : *current == ' ' ? Sign::Space
+                                                       : Sign::Minus);
+      ++current;
+    }
+    if (current not_eq end and *current == '#') {
+      alternate_ = true;
+      ++current;
+    }
+    if (current not_eq end and *current == '0') {
+      zero_ = true;
+      ++current;
+    }
+
+    if (current not_eq end and *current == '{') {
+      width_ = dynamic_index(current, end, indexer, names);
+      dynamic_width_ = true;
+    } else if (current not_eq end and detail::is_digit(*current)) {
+      width_ = to_number(current, end);
+    }
+
+    if (current not_eq end and *current == '.') {
       ++current;
+      if (current not_eq end and *current == '{') {
+        precision_ = dynamic_index(current, end, indexer, names);
+        dynamic_precision_ = true;
+      } else if (current not_eq end and detail::is_digit(*current)) {
+        precision_ = to_number(current, end);
+      } else {
+        _throw_format_error("Missing precision after '.'");
+      }
+      has_precision_ = true;
+    }
+
+    if (current not_eq end) {
+      parse_type(*current++);
+    }
+    if (current not_eq end) {
+      _throw_format_error(
+          "Unexpected additional characters found in format specifier");
+    }
+  }
+
+  constexpr inline auto parse_type(const char layout) -> void {
+    if (layout >= 'A' and layout <= 'Z') {
+      upper_ = true;
+    }
+    Type type{Type::None};
+    switch (layout) {
+      default: {
+        _throw_format_error("Invalid layout specifier");
+      }
+      case 'd': {
+        type = Type::Decimal;
+        break;
+      }
+      case 'X':
+      case 'x': {
+        type = Type::Hex;
+        break;
+      }
+      case 'O':
+      case 'o': {
+        type = Type::Octal;
+        break;
+      }
+      case 'B':
+      case 'b': {
+        type = Type::Binary;
+        break;
+      }
+      case 'F':
+      case 'f': {
+        type = Type::Fixed;
+        break;
+      }
+      case 'E':
+      case 'e': {
+        type = Type::Scientific;
+        break;
+      }
+      case 'G':
+      case 'g': {
+        type = Type::General;
+        break;
+      }
+      case 'A':
+      case 'a': {
+        type = Type::HexFloat;
+        break;
+      }
+      case 'C':
+      case 'c': {
+        type = Type::Char;
+        break;
+      }
+      case 's': {
+        type = Type::String;
+        break;
+      }
+      case 'P':
+      case 'p': {
+        type = Type::Pointer;
+        break;
+      }
+      case 'n': {
+        type = Type::Unbracketed;
+        break;
+      }
+    }
+    type_ = static_cast<::fmt::u8>(type);
+  }
+
+  /// @brief Parses `{}`, `{n}` or `{name}` and returns the argument index it
+  /// names.
+  static constexpr inline auto dynamic_index(
+      const char*& current, const char* const end,
+      detail::ArgIndexer* const indexer,
+      const ::std::span<const ::std::string_view> names) -> ::fmt::u16 {
+    ++current;
+    ::std::size_t index{0};
+    if (current not_eq end and *current == '}') {
+      if (indexer == nullptr) {
+        _throw_format_error("Dynamic width or precision is not allowed here");
+      }
+      index = indexer->automatic();
+    } else if (current not_eq end and not detail::is_digit(*current)) {
+      const char* const first{current};
+      while (current not_eq end and *current not_eq '}') {
+        ++current;
+      }
+      index = detail::named_position(
+          {first, static_cast<::std::size_t>(current - first)}, names);
+    } else {
+      index = to_number(current, end);
+      if (indexer not_eq nullptr) {
+        indexer->manual(index);
+      }
     }
+    if (current == end or *current not_eq '}') {
+      _throw_format_error("Missing '}' in dynamic width or precision");
+    }
+    ++current;
+    return static_cast<::fmt::u16>(index);
+  }
 
-    if (fmt.front() not_eq ':') {
-      position_ = to_number(fmt.data(), position_end ? position_end : end);
-      has_position_ = true;
-    }
-
-    if (size_begin) {
-      size_ = to_number(size_begin, size_end ? size_end : current);
-      has_size_ = true;
-    }
-
-    if (state not_eq State::SizeBegin) {
-      fill_ = fill_intermediate;
-    }
-
-    if (state == State::End or state == State::SizeBegin) {
-      char const layout{fmt.back()};
-      switch (layout) {
-        default: {
-          _throw_format_error("Invalid layout specifier");
-        }
-        case 'X':
-        case 'x': {
-          specifiers_ |= FormatSpecifier::HexMask;
-          break;
-        }
-        case 'O':
-        case 'o': {
-          specifiers_ |= FormatSpecifier::OctalMask;
-          break;
-        }
-        case 'B':
-        case 'b': {
-          specifiers_ |= FormatSpecifier::BinaryMask;
-          break;
-        }
-        case 'F':
-        case 'f': {
-          specifiers_ |= FormatSpecifier::FloatMask;
-          break;
-        }
-        case 'C':
-        case 'c': {
-          specifiers_ |= FormatSpecifier::CharMask;
-          break;
-        }
-        case 'P':
-        case 'p': {
-          specifiers_ |= FormatSpecifier::PointerMask;
-          break;
-        }
-      }
-    }
-  }
-  static constexpr inline auto to_number(const char* ptr, const char* const end)
-      -> ::std::size_t {
+  /// @brief Reads digits up to the first non-digit, into a 16-bit value.
+  static constexpr inline auto to_number(const char*& current,
+                                         const char* const end)
+      -> ::fmt::u16 {
     ::std::size_t value{0};
-    while (ptr not_eq end) {
-      if (*ptr < '0' or *ptr > '9') {
-        _throw_format_error("Invalid character in number");
+    while (current not_eq end and detail::is_digit(*current)) {
+      value = value * 10 + static_cast<::std::size_t>(*current - '0');
+      if (value > ::std::numeric_limits<::fmt::u16>::max()) {
+        _throw_format_error("Number in format specifier is too large");
       }
-      value *= 10;
-      value += *ptr - '0';
-      ++ptr;
+      ++current;
     }
-    return value;
+    return static_cast<::fmt::u16>(value);
   }
 
  public:
-  ::std::size_t specifiers_{0};
-  ::std::size_t position_{0};
-  ::std::size_t size_{0};
-  bool has_position_{false};
-  bool has_size_{false};
+  /// @brief The longest element specifier `nested_size_` can hold.
+  static constexpr ::std::size_t MaxNestedSize{511};
+
+  /// @brief Where the element specifier starts: an offset from the text this
+  /// was parsed from until bound, a pointer after.
+  union Nested {
+    ::fmt::u32 offset_;
+    const char* text_;
+  };
+
+  Nested nested_{.offset_ = 0};
+  ::fmt::u16 width_{0};
+  ::fmt::u16 precision_{0};
   char fill_{' '};
+  ::fmt::u8 type_ : 4 {0};
+  ::fmt::u8 align_ : 2 {0};
+  ::fmt::u8 sign_ : 2 {0};
+  ::fmt::u16 nested_size_ : 9 {0};
+  bool bound_ : 1 {false};
+  bool upper_ : 1 {false};
+  bool alternate_ : 1 {false};
+  bool zero_ : 1 {false};
+  bool has_precision_ : 1 {false};
+  bool dynamic_width_ : 1 {false};
+  bool dynamic_precision_ : 1 {false};
 };
+
+static_assert(sizeof(FormatSpecifier) <= 16);
+
+/// @brief One replacement field, `{[position][:specifier]}`.
+struct FormatField {
+  ::std::size_t position_;
+  FormatSpecifier specifier_;
+};
+
+namespace detail {
+
+/// @brief Finds the `}` closing a field whose text starts at `first`, just
+/// past its `{`, stepping over the braces of a dynamic width or precision.
+/// Returns `last` if the field is not closed.
+template <typename Unit>
+constexpr inline auto find_field_end(const Unit* first, const Unit* const last)
+    -> const Unit* {
+  ::std::size_t depth{1};
+  for (; first not_eq last; ++first) {
+    if (*first == '{') {
+      ++depth;
+    } else if (*first == '}' and --depth == 0) {
+      break;
+    }
+  }
+  return first;
+}
+
+/// @brief The text of a field from a format string of wider `Unit`s, as the
+/// `char`s `parse_field` reads. The field grammar, fill included, is ASCII.
+template <typename Unit>
+constexpr inline auto narrow_field(const ::std::basic_string_view<Unit> text)
+    -> ::std::string {
+  ::std::string narrow(text.size(), '\0');
+  for (::std::size_t i = 0; i < text.size(); ++i) {
+    if (static_cast<char32_t>(text[i]) > 0x7F) {
+      _throw_format_error("Replacement fields must be ASCII");
+    }
+    narrow[i] = static_cast<char>(text[i]);
+  }
+  return narrow;
+}
+
+/// @brief Parses the text between a field's braces. A field without an
+/// index takes the next automatic one, then each `{}` width or precision
+/// takes one more, so `{:{}}` reads the value and then its width. A `{name}`
+/// field is looked up in `names`, which only compile-time format strings
+/// have. The specifier's element specifier is an offset into `text`.
+constexpr inline auto parse_field(
+    const ::std::string_view text, ArgIndexer& indexer,
+    const ::std::span<const ::std::string_view> names = {}) -> FormatField {
+  const auto colon{text.find(':')};
+  const auto id{text.substr(0, colon)};
+
+  ::std::size_t position{0};
+  if (id.empty()) {
+    position = indexer.automatic();
+  } else if (not is_digit(id.front())) {
+    position = named_position(id, names);
+  } else {
+    for (const char c : id) {
+      if (not is_digit(c)) {
+        _throw_format_error("Invalid character in the positional argument");
+      }
+      position = position * 10 + static_cast<::std::size_t>(c - '0');
+    }
+    indexer.manual(position);
+  }
+
+  FormatSpecifier specifier{};
+  if (colon not_eq text.npos) {
+    specifier = FormatSpecifier{text.substr(colon + 1), indexer, names};
+    specifier.nested_.offset_ += static_cast<::fmt::u32>(colon + 1);
+  }
+  // Element specifiers are parsed again when formatting, but checked here
+  // so a bad one fails as early as the field itself.
+  for (auto nested{specifier.bind(text.data()).nested()}; not nested.empty();
+       nested = FormatSpecifier{nested}.nested()) {
+  }
+  return {position, specifier};
+}
+
+}  // namespace detail
+
 }  // namespace fmt
 
 #endif  // FORMAT_SPECIFIER_HPP_
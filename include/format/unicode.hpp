@@ -0,0 +1,369 @@
+#ifndef FORMAT_UNICODE_HPP_
+#define FORMAT_UNICODE_HPP_
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "format/config.hpp"
+
+#if FORMAT_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace fmt::detail {
+
+/// @brief U+FFFD, written in place of every malformed sequence.
+inline constexpr char32_t Replacement{0xFFFD};
+
+/// @brief The first byte in `[first, last)` that is not ASCII, or `last`.
+/// Checks 16 bytes per step with SSE2 when the target has it.
+constexpr inline auto ascii_end(const char* first, const char* const last)
+    -> const char* {
+  if !consteval {
+#if FORMAT_HAS_SSE2
+    while (last - first >= 16) {
+      const __m128i chunk{
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(first))};
+      const auto mask{static_cast<unsigned>(_mm_movemask_epi8(chunk))};
+      if (mask not_eq 0) {
+        return first + ::std::countr_zero(mask);
+      }
+      first += 16;
+    }
+#endif
+  }
+  while (first not_eq last and static_cast<unsigned char>(*first) < 0x80) {
+    ++first;
+  }
+  return first;
+}
+
+/// @brief Decodes the code point at `ptr` and moves past it. A malformed,
+/// overlong or truncated sequence, or an encoded surrogate, decodes as
+/// `Replacement` and consumes one byte.
+constexpr inline auto decode_utf8(const char*& ptr,
+                                  const char* const last) noexcept
+    -> char32_t {
+  const auto lead{static_cast<unsigned char>(*ptr)};
+  if (lead < 0x80) {
+    ++ptr;
+    return lead;
+  }
+  const ::std::size_t length{lead >= 0xF0   ? 4u
+                             : lead >= 0xE0 ? 3u
+                             : lead >= 0xC0 ? 2u
+                                            : 0u};
+  if (length == 0 or lead > 0xF4 or
+      static_cast<::std::size_t>(last - ptr) < length) {
+    ++ptr;
+    return Replacement;
+  }
+
+  char32_t code{static_cast<char32_t>(lead & (0x7F >> length))};
+  for (::std::size_t i = 1; i < length; ++i) {
+    const auto next{static_cast<unsigned char>(ptr[i])};
+    if ((next & 0xC0) not_eq 0x80) {
+      ++ptr;
+      return Replacement;
+    }
+    code = (code << 6) | (next & 0x3F);
+  }
+  constexpr char32_t Smallest[]{0, 0, 0x80, 0x800, 0x10000};
+  if (code < Smallest[length] or code > 0x10FFFF or
+      (code >= 0xD800 and code <= 0xDFFF)) {
+    ++ptr;
+    return Replacement;
+  }
+  ptr += length;
+  return code;
+}
+
+/// @brief Columns a terminal gives `code`: 2 for East Asian wide and
+/// fullwidth characters and emoji, as `std::format` estimates them, 0 for
+/// combining marks, zero-width spaces and variation selectors, 1 otherwise.
+constexpr inline auto code_point_width(const char32_t code) noexcept
+    -> ::std::size_t {
+  struct Range {
+    char32_t first_;
+    char32_t last_;
+  };
+  constexpr Range Zero[]{
+      {0x0300, 0x036F}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F},
+      {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+  };
+  constexpr Range Wide[]{
+      {0x1100, 0x115F},   {0x2329, 0x232A},   {0x2E80, 0x303E},
+      {0x3040, 0xA4CF},   {0xAC00, 0xD7A3},   {0xF900, 0xFAFF},
+      {0xFE10, 0xFE19},   {0xFE30, 0xFE6F},   {0xFF00, 0xFF60},
+      {0xFFE0, 0xFFE6},   {0x1F300, 0x1F64F}, {0x1F900, 0x1F9FF},
+      {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+  };
+  if (code < 0x0300) {
+    return 1;
+  }
+  for (const auto& range : Zero) {
+    if (code >= range.first_ and code <= range.last_) {
+      return 0;
+    }
+  }
+  for (const auto& range : Wide) {
+    if (code >= range.first_ and code <= range.last_) {
+      return 2;
+    }
+  }
+  return 1;
+}
+
+/// @brief The number of columns `text` takes up. ASCII runs are counted a
+/// vector at a time; only the rest is decoded.
+constexpr inline auto display_width(const ::std::string_view text) noexcept
+    -> ::std::size_t {
+  const char* ptr{text.data()};
+  const char* const last{ptr + text.size()};
+  ::std::size_t width{0};
+  while (ptr not_eq last) {
+    const char* const ascii{ascii_end(ptr, last)};
+    width += static_cast<::std::size_t>(ascii - ptr);
+    ptr = ascii;
+    if (ptr not_eq last) {
+      width += code_point_width(decode_utf8(ptr, last));
+    }
+  }
+  return width;
+}
+
+/// @brief The length of `text` up to a UTF-8 sequence cut off at its end,
+/// for text that arrives in chunks.
+constexpr inline auto complete_utf8_size(const ::std::string_view text) noexcept
+    -> ::std::size_t {
+  const auto size{text.size()};
+  for (::std::size_t back = 1; back <= 3 and back <= size; ++back) {
+    const auto c{static_cast<unsigned char>(text[size - back])};
+    if ((c & 0xC0) not_eq 0x80) {
+      const ::std::size_t length{c >= 0xF0   ? 4u
+                                 : c >= 0xE0 ? 3u
+                                 : c >= 0xC0 ? 2u
+                                             : 1u};
+      return length > back ? size - back : size;
+    }
+  }
+  return size;
+}
+
+/// @brief The longest prefix of `text` no wider than `columns`, never
+/// splitting a code point.
+constexpr inline auto truncate_to_width(const ::std::string_view text,
+                                        ::std::size_t columns) noexcept
+    -> ::std::string_view {
+  const char* ptr{text.data()};
+  const char* const last{ptr + text.size()};
+  while (ptr not_eq last) {
+    const char* const ascii{ascii_end(ptr, last)};
+    const auto run{static_cast<::std::size_t>(ascii - ptr)};
+    if (run >= columns) {
+      ptr += columns;
+      break;
+    }
+    columns -= run;
+    ptr = ascii;
+    if (ptr not_eq last) {
+      const char* next{ptr};
+      const auto width{code_point_width(decode_utf8(next, last))};
+      if (width > columns) {
+        break;
+      }
+      columns -= width;
+      ptr = next;
+    }
+  }
+  return text.substr(0, static_cast<::std::size_t>(ptr - text.data()));
+}
+
+/// @brief Writes `code` as UTF-8 and returns the end of what was written.
+constexpr inline auto encode_utf8(const char32_t code, char* out) noexcept
+    -> char* {
+  if (code < 0x80) {
+    *out++ = static_cast<char>(code);
+  } else if (code < 0x800) {
+    *out++ = static_cast<char>(0xC0 | (code >> 6));
+    *out++ = static_cast<char>(0x80 | (code & 0x3F));
+  } else if (code < 0x10000) {
+    *out++ = static_cast<char>(0xE0 | (code >> 12));
+    *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (code & 0x3F));
+  } else {
+    *out++ = static_cast<char>(0xF0 | (code >> 18));
+    *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (code & 0x3F));
+  }
+  return out;
+}
+
+constexpr inline auto utf8_length(const char32_t code) noexcept
+    -> ::std::size_t {
+  return code < 0x80 ? 1 : code < 0x800 ? 2 : code < 0x10000 ? 3 : 4;
+}
+
+/// @brief Decodes the code point at `ptr` in UTF-16 (two-byte `Unit`s) or
+/// UTF-32 and moves past it. Lone surrogates and values past U+10FFFF decode
+/// as `Replacement`.
+template <typename Unit>
+constexpr inline auto decode_unit(const Unit*& ptr,
+                                  const Unit* const last) noexcept
+    -> char32_t {
+  const auto unit{static_cast<char32_t>(*ptr++)};
+  if constexpr (sizeof(Unit) == 2) {
+    if (unit >= 0xD800 and unit <= 0xDBFF and ptr not_eq last) {
+      const auto low{static_cast<char32_t>(*ptr)};
+      if (low >= 0xDC00 and low <= 0xDFFF) {
+        ++ptr;
+        return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+      }
+    }
+  }
+  if ((unit >= 0xD800 and unit <= 0xDFFF) or unit > 0x10FFFF) {
+    return Replacement;
+  }
+  return unit;
+}
+
+/// @brief The number of two-byte units starting at `first` that are all
+/// ASCII, a multiple of 8, found 8 units at a time with SSE2.
+template <typename Unit>
+inline auto ascii_units(const Unit* const first, const Unit* const last)
+    -> ::std::size_t {
+  ::std::size_t count{0};
+#if FORMAT_HAS_SSE2
+  if constexpr (sizeof(Unit) == 2) {
+    const __m128i high{_mm_set1_epi16(static_cast<short>(0xFF80))};
+    while (last - (first + count) >= 8) {
+      const __m128i chunk{
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + count))};
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chunk, high),
+                                            _mm_setzero_si128())) not_eq
+          0xFFFF) {
+        break;
+      }
+      count += 8;
+    }
+  }
+#else
+  (void)first;
+  (void)last;
+#endif
+  return count;
+}
+
+/// @brief The length of `text` (UTF-8, UTF-16 or UTF-32 by the size of
+/// `Unit`) once converted to UTF-8.
+template <typename Unit>
+constexpr inline auto utf8_size(const ::std::basic_string_view<Unit> text)
+    -> ::std::size_t {
+  if constexpr (sizeof(Unit) == 1) {
+    return text.size();
+  } else {
+    const Unit* ptr{text.data()};
+    const Unit* const last{ptr + text.size()};
+    ::std::size_t size{0};
+    while (ptr not_eq last) {
+      if !consteval {
+        const auto ascii{ascii_units(ptr, last)};
+        size += ascii;
+        ptr += ascii;
+        if (ptr == last) {
+          break;
+        }
+      }
+      size += utf8_length(decode_unit(ptr, last));
+    }
+    return size;
+  }
+}
+
+/// @brief Converts `text` to UTF-8 at `out`, which has room for
+/// `utf8_size(text)` characters, and returns the end of what was written.
+/// ASCII runs of UTF-16 are narrowed 8 units at a time with SSE2.
+template <typename Unit>
+constexpr inline auto to_utf8(const ::std::basic_string_view<Unit> text,
+                              char* out) -> char* {
+  const Unit* ptr{text.data()};
+  const Unit* const last{ptr + text.size()};
+  if constexpr (sizeof(Unit) == 1) {
+    while (ptr not_eq last) {
+      *out++ = static_cast<char>(*ptr++);
+    }
+  } else {
+    while (ptr not_eq last) {
+      if !consteval {
+#if FORMAT_HAS_SSE2
+        if constexpr (sizeof(Unit) == 2) {
+          const auto ascii{ascii_units(ptr, last)};
+          for (::std::size_t i = 0; i < ascii; i += 8) {
+            const __m128i chunk{
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + i))};
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i),
+                             _mm_packus_epi16(chunk, chunk));
+          }
+          ptr += ascii;
+          out += ascii;
+          if (ptr == last) {
+            break;
+          }
+        }
+#endif
+      }
+      out = encode_utf8(decode_unit(ptr, last), out);
+    }
+  }
+  return out;
+}
+
+/// @brief Converts UTF-8 `text` to UTF-16 (two-byte `Unit`s) or UTF-32 at
+/// `out`, which has room for `text.size()` units, and returns the end of
+/// what was written. ASCII runs are widened 16 bytes at a time with SSE2.
+template <typename Unit>
+constexpr inline auto from_utf8(const ::std::string_view text, Unit* out)
+    -> Unit* {
+  const char* ptr{text.data()};
+  const char* const last{ptr + text.size()};
+  while (ptr not_eq last) {
+    if !consteval {
+#if FORMAT_HAS_SSE2
+      if constexpr (sizeof(Unit) == 2) {
+        const __m128i zero{_mm_setzero_si128()};
+        while (last - ptr >= 16) {
+          const __m128i chunk{
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr))};
+          if (_mm_movemask_epi8(chunk) not_eq 0) {
+            break;
+          }
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                           _mm_unpacklo_epi8(chunk, zero));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8),
+                           _mm_unpackhi_epi8(chunk, zero));
+          ptr += 16;
+          out += 16;
+        }
+        if (ptr == last) {
+          break;
+        }
+      }
+#endif
+    }
+    const char32_t code{decode_utf8(ptr, last)};
+    if (sizeof(Unit) == 2 and code >= 0x10000) {
+      *out++ = static_cast<Unit>(0xD800 + ((code - 0x10000) >> 10));
+      *out++ = static_cast<Unit>(0xDC00 + ((code - 0x10000) & 0x3FF));
+    } else {
+      *out++ = static_cast<Unit>(code);
+    }
+  }
+  return out;
+}
+
+}  // namespace fmt::detail
+
+#endif  // FORMAT_UNICODE_HPP_
@@ -0,0 +1,314 @@
+#ifndef FORMAT_WIDE_HPP_
+#define FORMAT_WIDE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "format/buffer.hpp"
+#include "format/concept.hpp"
+#include "format/format.hpp"
+#include "format/formatter.hpp"
+#include "format/specifier.hpp"
+#include "format/unicode.hpp"
+
+namespace fmt {
+
+namespace detail {
+
+/// @brief Strings of `Unit`s in any of the spellings `IsString` accepts for
+/// `char`.
+template <typename Type, typename Unit>
+concept IsStringOf =
+    IsAnyOf<::std::decay_t<Type>, TypeList<const Unit*, Unit*>> or
+    IsAnyOf<Type, TypeList<::std::basic_string<Unit>,
+                           ::std::basic_string_view<Unit>>>;
+
+/// @brief Converts `text` to UTF-16 (two-byte `Unit`s) or UTF-32 with a
+/// single allocation, trimmed to what was written.
+template <typename Unit>
+inline auto from_utf8(const ::std::string_view text)
+    -> ::std::basic_string<Unit> {
+  ::std::basic_string<Unit> out{};
+  out.resize_and_overwrite(text.size(), [&](Unit* data, ::std::size_t) {
+    return static_cast<::std::size_t>(from_utf8(text, data) - data);
+  });
+  return out;
+}
+
+/// @brief Formats UTF-8, UTF-16, UTF-32 and wide strings as UTF-8. Without a
+/// width or precision the text is converted straight into the output;
+/// otherwise it is converted first and laid out as a `std::string_view`.
+template <typename Unit>
+struct UnicodeStringFormatter {
+  static auto buf_print(Buffer& str, const ::std::basic_string_view<Unit> val,
+                        const FormatSpecifier& specifiers) -> void {
+    if (is_plain(specifiers)) {
+      if (char* dest{str.claim(utf8_size(val))}) {
+        to_utf8(val, dest);
+        return;
+      }
+    }
+    const MemoryBuffer<> utf8{converted(val)};
+    Formatter<::std::string_view>::buf_print(str, utf8.view(), specifiers);
+  }
+  static auto size_hint(const ::std::basic_string_view<Unit> val,
+                        const FormatSpecifier& specifiers) -> ::std::size_t {
+    if (is_plain(specifiers)) {
+      return utf8_size(val);
+    }
+    const MemoryBuffer<> utf8{converted(val)};
+    return Formatter<::std::string_view>::size_hint(utf8.view(), specifiers);
+  }
+
+ private:
+  static auto is_plain(const FormatSpecifier& specifiers) noexcept -> bool {
+    return specifiers.width() == 0 and not specifiers.has_precision();
+  }
+  static auto converted(const ::std::basic_string_view<Unit> val)
+      -> MemoryBuffer<> {
+    MemoryBuffer<> utf8{};
+    const auto size{utf8_size(val)};
+    if (char* dest{utf8.claim(size)}) {
+      to_utf8(val, dest);
+    }
+    return utf8;
+  }
+};
+
+}  // namespace detail
+
+template <detail::IsStringOf<char8_t> Type>
+struct Formatter<Type> : detail::UnicodeStringFormatter<char8_t> {};
+template <detail::IsStringOf<char16_t> Type>
+struct Formatter<Type> : detail::UnicodeStringFormatter<char16_t> {};
+template <detail::IsStringOf<char32_t> Type>
+struct Formatter<Type> : detail::UnicodeStringFormatter<char32_t> {};
+template <detail::IsStringOf<wchar_t> Type>
+struct Formatter<Type> : detail::UnicodeStringFormatter<wchar_t> {};
+
+/// @brief Converts UTF-8 to UTF-16. Malformed input becomes U+FFFD.
+[[nodiscard]] inline auto to_utf16(const ::std::string_view text)
+    -> ::std::u16string {
+  return detail::from_utf8<char16_t>(text);
+}
+
+/// @brief Converts UTF-8 to a wide string: UTF-16 where `wchar_t` has two
+/// bytes, UTF-32 where it has four.
+[[nodiscard]] inline auto to_wide(const ::std::string_view text)
+    -> ::std::wstring {
+  return detail::from_utf8<wchar_t>(text);
+}
+
+namespace detail {
+
+template <typename Unit>
+inline auto to_utf8(const ::std::basic_string_view<Unit> text)
+    -> ::std::string {
+  ::std::string out{};
+  out.resize_and_overwrite(utf8_size(text),
+                           [&](char* data, const ::std::size_t size) {
+                             to_utf8(text, data);
+                             return size;
+                           });
+  return out;
+}
+
+}  // namespace detail
+
+/// @brief Converts UTF-16, UTF-32 or a wide string to UTF-8 with a single
+/// exact-size allocation. Lone surrogates become U+FFFD.
+[[nodiscard]] inline auto to_utf8(const ::std::u16string_view text)
+    -> ::std::string {
+  return detail::to_utf8(text);
+}
+[[nodiscard]] inline auto to_utf8(const ::std::u32string_view text)
+    -> ::std::string {
+  return detail::to_utf8(text);
+}
+[[nodiscard]] inline auto to_utf8(const ::std::wstring_view text)
+    -> ::std::string {
+  return detail::to_utf8(text);
+}
+
+namespace detail {
+
+/// @brief A formatting target that converts to UTF-16 or UTF-32 as it fills,
+/// appending each chunk straight to `out`, so the UTF-8 text never exists in
+/// full. A sequence split between chunks is carried over to the next one.
+template <typename Unit>
+class TranscodingBuffer final : public Buffer {
+ public:
+  explicit TranscodingBuffer(::std::basic_string<Unit>& out)
+      : Buffer{grow}, out_{out} {
+    set(data_, sizeof(data_));
+  }
+
+  /// @brief Converts everything written so far; a sequence still incomplete
+  /// at this point is malformed and becomes U+FFFD.
+  auto flush() -> void { convert(size_); }
+
+ private:
+  static auto grow(Buffer& buf, [[maybe_unused]] const ::std::size_t count)
+      -> void {
+    auto& self{static_cast<TranscodingBuffer&>(buf)};
+    self.convert(complete_utf8_size({self.data_, self.size_}));
+  }
+
+  auto convert(const ::std::size_t count) -> void {
+    const auto before{out_.size()};
+    out_.resize_and_overwrite(before + count,
+                              [&](Unit* data, ::std::size_t) {
+                                return static_cast<::std::size_t>(
+                                    from_utf8({data_, count}, data + before) -
+                                    data);
+                              });
+    ::std::copy(data_ + count, data_ + size_, data_);
+    flushed(count);
+    size_ -= count;
+  }
+
+  ::std::basic_string<Unit>& out_;
+  char data_[256]{};
+};
+
+template <typename Unit, typename... ArgsType>
+inline auto format_converted(const FormatString<ArgsType...>& fmt,
+                             const ArgsType&... args_pack)
+    -> ::std::basic_string<Unit> {
+  ::std::basic_string<Unit> out{};
+  TranscodingBuffer<Unit> buf{out};
+  format_to(buf, fmt, args_pack...);
+  buf.flush();
+  return out;
+}
+
+/// @brief Appends UTF-8 `text` to `out` as `Unit`s.
+template <typename Unit>
+inline auto append_utf8(::std::basic_string<Unit>& out,
+                        const ::std::string_view text) -> void {
+  const auto before{out.size()};
+  out.resize_and_overwrite(before + text.size(), [&](Unit* data,
+                                                     ::std::size_t) {
+    if constexpr (sizeof(Unit) == 1) {
+      ::std::copy(text.begin(), text.end(), data + before);
+      return before + text.size();
+    } else {
+      return static_cast<::std::size_t>(from_utf8(text, data + before) - data);
+    }
+  });
+}
+
+/// @brief The specifier of `segment`, a field of `fmt`. An element
+/// specifier is narrowed into `narrow`, which the result then points into.
+template <typename Unit>
+inline auto unit_specifier(const ::std::basic_string_view<Unit> fmt,
+                           const FormatSegment& segment,
+                           ::std::string& narrow) -> FormatSpecifier {
+  const FormatSpecifier& specifier{segment.specifier_};
+  if (specifier.nested_size_ == 0) {
+    return specifier;
+  }
+  narrow = narrow_field(
+      fmt.substr(segment.literal_offset_ + segment.literal_size_ + 1,
+                 specifier.nested_.offset_ + specifier.nested_size_));
+  return specifier.bind(narrow.data());
+}
+
+/// @brief The formatting loop for a format string of `Unit`s. Literal text
+/// is copied unchanged; each field is formatted as UTF-8, so widths count
+/// display columns as they do for `char`, and then converted.
+template <typename Unit>
+inline auto vformat_units(::std::basic_string<Unit>& out,
+                          const ::std::basic_string_view<Unit> fmt,
+                          const ::std::span<const FormatSegment> segments,
+                          const ::std::basic_string_view<Unit> tail,
+                          const ::std::span<const FormatArg> args) -> void {
+  MemoryBuffer<> field{};
+  ::std::string narrow{};
+  for (const auto& segment : segments) {
+    out.append(fmt.substr(segment.literal_offset_, segment.literal_size_));
+    field.clear();
+    format_field(field, args, segment.position_,
+                 unit_specifier(fmt, segment, narrow));
+    append_utf8(out, field.view());
+  }
+  out.append(tail);
+}
+
+template <typename Unit, typename... ArgsType>
+inline auto format_units(const FormatStringImpl<Unit, ArgsType...>& fmt,
+                         const ArgsType&... args_pack)
+    -> ::std::basic_string<Unit> {
+  const FormatArgs<ArgsType...> args{args_pack...};
+  ::std::basic_string<Unit> out{};
+  out.reserve(fmt.length());
+  vformat_units(out, fmt.get_fmt(), fmt.segments(), fmt.tail(), args.view());
+  return out;
+}
+
+}  // namespace detail
+
+/// @brief Format strings of wide, UTF-8 `char8_t`, UTF-16 and UTF-32 units,
+/// checked at compile time like `FormatString`.
+template <typename... ArgsType>
+using WFormatString =
+    FormatStringImpl<wchar_t, ::std::type_identity_t<ArgsType>...>;
+template <typename... ArgsType>
+using U8FormatString =
+    FormatStringImpl<char8_t, ::std::type_identity_t<ArgsType>...>;
+template <typename... ArgsType>
+using U16FormatString =
+    FormatStringImpl<char16_t, ::std::type_identity_t<ArgsType>...>;
+template <typename... ArgsType>
+using U32FormatString =
+    FormatStringImpl<char32_t, ::std::type_identity_t<ArgsType>...>;
+
+/// @brief Formats into a string of the format string's own units. Fields
+/// keep the `char` grammar and must be ASCII, fill included; arguments of
+/// any encoding are converted to it.
+template <typename... ArgsType>
+[[nodiscard]] auto format(WFormatString<ArgsType...> fmt,
+                          const ArgsType&... args_pack) -> ::std::wstring {
+  return detail::format_units(fmt, args_pack...);
+}
+template <typename... ArgsType>
+[[nodiscard]] auto format(U8FormatString<ArgsType...> fmt,
+                          const ArgsType&... args_pack) -> ::std::u8string {
+  return detail::format_units(fmt, args_pack...);
+}
+template <typename... ArgsType>
+[[nodiscard]] auto format(U16FormatString<ArgsType...> fmt,
+                          const ArgsType&... args_pack) -> ::std::u16string {
+  return detail::format_units(fmt, args_pack...);
+}
+template <typename... ArgsType>
+[[nodiscard]] auto format(U32FormatString<ArgsType...> fmt,
+                          const ArgsType&... args_pack) -> ::std::u32string {
+  return detail::format_units(fmt, args_pack...);
+}
+
+/// @brief Formats as usual and returns the result as UTF-16. The format
+/// string and arguments are UTF-8; the output is converted chunk by chunk as
+/// it is written.
+template <typename... ArgsType>
+[[nodiscard]] auto format_utf16(FormatString<ArgsType...> fmt,
+                                const ArgsType&... args_pack)
+    -> ::std::u16string {
+  return detail::format_converted<char16_t>(fmt, args_pack...);
+}
+
+/// @brief `format_utf16` for `wchar_t`, as Windows APIs take.
+template <typename... ArgsType>
+[[nodiscard]] auto format_wide(FormatString<ArgsType...> fmt,
+                               const ArgsType&... args_pack)
+    -> ::std::wstring {
+  return detail::format_converted<wchar_t>(fmt, args_pack...);
+}
+
+}  // namespace fmt
+
+#endif  // FORMAT_WIDE_HPP_
@@ -0,0 +1,113 @@
+// `import format;` for the whole public API. Built by the `format_module`
+// CMake target on top of `format_core`.
+
+module;
+
+#include "format/async.hpp"
+#include "format/compile.hpp"
+#include "format/format.hpp"
+#include "format/formatter.hpp"
+#include "format/named.hpp"
+#include "format/parallel.hpp"
+#include "format/print.hpp"
+#include "format/ranges.hpp"
+#include "format/runtime.hpp"
+#include "format/wide.hpp"
+
+export module format;
+
+export namespace fmt {
+
+using ::fmt::f32;
+using ::fmt::f64;
+using ::fmt::i16;
+using ::fmt::i32;
+using ::fmt::i64;
+using ::fmt::i8;
+using ::fmt::isize;
+using ::fmt::u16;
+using ::fmt::u32;
+using ::fmt::u64;
+using ::fmt::u8;
+using ::fmt::usize;
+
+using ::fmt::Align;
+using ::fmt::Buffer;
+using ::fmt::BufPrint;
+using ::fmt::FormatError;
+using ::fmt::FormatSpecifier;
+using ::fmt::Formatter;
+using ::fmt::HasSizeHint;
+using ::fmt::IsFormattable;
+using ::fmt::MemoryBuffer;
+using ::fmt::Sign;
+using ::fmt::buf_print;
+
+namespace pmr {
+using ::fmt::pmr::MemoryBuffer;
+}  // namespace pmr
+
+using ::fmt::FormatArg;
+using ::fmt::FormatArgs;
+using ::fmt::FormatString;
+using ::fmt::FormatStringImpl;
+using ::fmt::FormatToNResult;
+using ::fmt::format;
+using ::fmt::format_into;
+using ::fmt::format_to;
+using ::fmt::format_to_n;
+using ::fmt::formatted_size;
+using ::fmt::make_format_args;
+
+using ::fmt::IsNamedArg;
+using ::fmt::NamedArg;
+using ::fmt::arg;
+
+namespace literals {
+using ::fmt::literals::operator""_a;
+}  // namespace literals
+
+using ::fmt::CompiledFormat;
+using ::fmt::FixedString;
+using ::fmt::compile;
+
+using ::fmt::FormatCache;
+using ::fmt::ParsedFormat;
+using ::fmt::RuntimeFormat;
+using ::fmt::runtime;
+using ::fmt::vformat;
+using ::fmt::vformat_to;
+
+using ::fmt::print;
+
+using ::fmt::AsyncOptions;
+using ::fmt::AsyncSink;
+using ::fmt::AsyncStats;
+using ::fmt::QueuePolicy;
+using ::fmt::async_flush;
+using ::fmt::async_print;
+using ::fmt::async_shutdown;
+using ::fmt::async_start;
+using ::fmt::async_stats;
+
+using ::fmt::format_range_parallel;
+
+using ::fmt::JoinView;
+using ::fmt::join;
+
+using ::fmt::format_utf16;
+using ::fmt::format_wide;
+using ::fmt::to_utf16;
+using ::fmt::to_utf8;
+using ::fmt::to_wide;
+
+using ::fmt::InstrumentationCounters;
+
+namespace instrumentation {
+using ::fmt::instrumentation::Enabled;
+using ::fmt::instrumentation::reset;
+using ::fmt::instrumentation::snapshot;
+using ::fmt::instrumentation::thread_snapshot;
+}  // namespace instrumentation
+
+}  // namespace fmt
@@ -0,0 +1,26 @@
+// The compiled half of the `format_core` library: the builtin formatters and
+// the runtime engine, built once instead of in every translation unit.
+
+#define FORMAT_CORE_SOURCE
+
+#include "format/format.hpp"
+#include "format/formatter.hpp"
+#include "format/print.hpp"
+#include "format/runtime.hpp"
+
+namespace fmt {
+
+namespace detail {
+
+template struct IntegerFormatter<::fmt::i16>;
+template struct IntegerFormatter<::fmt::i32>;
+template struct IntegerFormatter<::fmt::i64>;
+template struct IntegerFormatter<::fmt::u16>;
+template struct IntegerFormatter<::fmt::u32>;
+template struct IntegerFormatter<::fmt::u64>;
+template struct FloatFormatter<::fmt::f32>;
+template struct FloatFormatter<::fmt::f64>;
+
+}  // namespace detail
+
+}  // namespace fmt
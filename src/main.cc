@@ -16,7 +16,7 @@ namespace fmt {
 template <>
 class Formatter<Foo> {
  public:
-  static void buf_print(std::string& str, [[maybe_unused]] const Foo& val,
+  static void buf_print(Buffer& str, [[maybe_unused]] const Foo& val,
                         [[maybe_unused]] const FormatSpecifier& specifier) {
     str.append("Foo");
   }
@@ -24,12 +24,12 @@ class Formatter<Foo> {
 template <>
 class Formatter<Point> {
  public:
-  static void buf_print(std::string& str, [[maybe_unused]] const Point& val,
-                        [[maybe_unused]] const FormatSpecifier& specifier) {
+  static void buf_print(Buffer& str, const Point& val,
+                        const FormatSpecifier& specifier) {
     str.append("(");
-    str.append(detail::to_float(val.x));
+    fmt::buf_print(str, val.x, specifier);
     str.append(", ");
-    str.append(detail::to_float(val.y));
+    fmt::buf_print(str, val.y, specifier);
     str.append(")");
   }
 };
@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "check.hpp"
+#include "format/format.hpp"
+
+// Type-erased arguments stored by value, without the heap.
+
+namespace {
+
+struct Point {
+  int x_;
+  int y_;
+};
+
+}  // namespace
+
+template <>
+struct fmt::Formatter<Point> {
+  static constexpr auto buf_print(Buffer& str, const Point& val,
+                                  const FormatSpecifier& specifier) -> void {
+    str.push_back('(');
+    fmt::buf_print(str, val.x_, specifier);
+    str.append(", ");
+    fmt::buf_print(str, val.y_, specifier);
+    str.push_back(')');
+  }
+};
+
+static_assert(sizeof(fmt::FormatArg) <= 32);
+static_assert(std::is_trivially_copyable_v<fmt::FormatArg>);
+
+FORMAT_TEST(arguments_keep_their_kind) {
+  using Kind = fmt::FormatArg::Kind;
+  const std::string text{"s"};
+  const auto args{fmt::make_format_args(
+      short{1}, 2U, std::int64_t{3}, std::uint64_t{4}, 'c', 1.5F, 2.5,
+      text, "literal", Point{1, 2})};
+  CHECK(args[0].kind() == Kind::I32);
+  CHECK(args[1].kind() == Kind::U32);
+  CHECK(args[2].kind() == Kind::I64);
+  CHECK(args[3].kind() == Kind::U64);
+  CHECK(args[4].kind() == Kind::Char);
+  CHECK(args[5].kind() == Kind::F32);
+  CHECK(args[6].kind() == Kind::F64);
+  CHECK(args[7].kind() == Kind::String);
+  CHECK(args[8].kind() == Kind::String);
+  CHECK(args[9].kind() == Kind::Custom);
+}
+
+FORMAT_TEST(mixed_arguments) {
+  const std::string text{"str"};
+  const std::string_view view{"view"};
+  CHECK_EQ(fmt::format("{} {} {} {} {}", -1, 2U, text, view, Point{3, 4}),
+           "-1 2 str view (3, 4)");
+  CHECK_EQ(fmt::format("{:x}", Point{10, 11}), "(a, b)");
+  CHECK_EQ(fmt::format("{}|{}", std::int64_t{-9000000000},
+                       std::uint64_t{18446744073709551615U}),
+           "-9000000000|18446744073709551615");
+}
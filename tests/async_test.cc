@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "format/async.hpp"
+#include "format/ranges.hpp"
+
+// Asynchronous printing on a background worker.
+
+static_assert(fmt::detail::IsAsyncReference<std::span<const int>>);
+static_assert(fmt::detail::IsAsyncReference<
+              decltype(fmt::join(std::vector<int>{}, ","))>);
+static_assert(not fmt::detail::IsAsyncReference<std::vector<int>>);
+static_assert(not fmt::detail::IsAsyncReference<std::string_view>);
+
+// A record refers to its interned format string instead of copying it.
+static_assert(sizeof(fmt::detail::AsyncPayload<int, int>::Values) <= 16);
+
+namespace {
+
+auto contents(std::FILE* const file) -> std::string {
+  std::rewind(file);
+  std::string text{};
+  char chunk[4096];
+  while (const auto size{std::fread(chunk, 1, sizeof(chunk), file)}) {
+    text.append(chunk, size);
+  }
+  return text;
+}
+
+}  // namespace
+
+FORMAT_TEST(async_print_writes_in_order) {
+  // The smallest ring, so producers have to wait for the worker.
+  fmt::async_start({.ring_size_ = 1, .policy_ = fmt::QueuePolicy::Block});
+  std::FILE* const file{std::tmpfile()};
+  std::string expected{};
+  for (int i = 0; i < 2000; ++i) {
+    std::string text(static_cast<std::size_t>(i % 7), 'x');
+    fmt::async_print(file, "{} {:>3} {}\n", i, "ab", text);
+    expected += fmt::format("{} {:>3} {}\n", i, "ab", text);
+  }
+  fmt::async_flush();
+  CHECK_EQ(contents(file), expected);
+  std::fclose(file);
+}
+
+FORMAT_TEST(async_print_named_and_reused_fields) {
+  using namespace fmt::literals;
+  std::FILE* const file{std::tmpfile()};
+  {
+    std::string user{"ann"};
+    fmt::async_print(file, "{user} took {ms}ms\n", "user"_a = user,
+                     "ms"_a = 42);
+    user = "overwritten";
+  }
+  fmt::async_print(file, "{0}{0}{0}{0}{0:x}\n", 10);
+  fmt::async_print(file, "{}\n", std::vector<int>{1, 2});
+  fmt::async_flush();
+  CHECK_EQ(contents(file), "ann took 42ms\n10101010a\n[1, 2]\n");
+  std::fclose(file);
+}
+
+FORMAT_TEST(async_print_from_threads) {
+  std::FILE* const file{std::tmpfile()};
+  std::vector<std::thread> threads{};
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 500; ++i) {
+        fmt::async_print(file, "{}\n", 123456);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  fmt::async_flush();
+  CHECK_EQ(contents(file).size(), 4U * 500U * 7U);
+  std::fclose(file);
+}
+
+FORMAT_TEST(async_format_strings_are_interned) {
+  using Formats = fmt::detail::AsyncFormats<int>;
+  const auto* const first{Formats::intern("{}\n")};
+  CHECK(Formats::intern("{}\n") == first);
+  CHECK(Formats::intern("<{}>") not_eq first);
+  CHECK_EQ(first->segments().size(), 1U);
+}
+
+// Last in this file: the logger stays shut down, and later calls write on
+// their own thread.
+FORMAT_TEST(async_shutdown_wakes_waiting_producers) {
+  std::FILE* const file{std::tmpfile()};
+  std::thread producer{[&] {
+    for (int i = 0; i < 20000; ++i) {
+      fmt::async_print(file, "{}\n", i % 10);
+    }
+  }};
+  fmt::async_shutdown();
+  // Whatever was queued is written; the rest goes out on the producer's
+  // own thread, which must not be left waiting for room.
+  producer.join();
+  const auto text{contents(file)};
+  CHECK(not text.empty() and text.size() <= 20000U * 2U);
+  CHECK_EQ(text.size() % 2, 0U);
+  std::fclose(file);
+}
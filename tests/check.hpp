@@ -0,0 +1,86 @@
+#ifndef FORMAT_TESTS_CHECK_HPP_
+#define FORMAT_TESTS_CHECK_HPP_
+
+#include <concepts>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+namespace fmt::test {
+
+/// @brief One `FORMAT_TEST`, run by `tests/main.cc` in registration order.
+struct Case {
+  const char* name_;
+  auto (*run_)() -> void;
+};
+
+inline auto cases() -> ::std::vector<Case>& {
+  static ::std::vector<Case> registered{};
+  return registered;
+}
+
+inline auto failures() -> int& {
+  static int count{0};
+  return count;
+}
+
+struct Register {
+  Register(const char* const name, auto (*const run)()->void) {
+    cases().push_back({name, run});
+  }
+};
+
+inline auto fail(const char* const file, const int line,
+                 const char* const what) -> void {
+  ++failures();
+  ::std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+}
+
+/// @brief Reports a mismatch, with both values when they are strings.
+template <typename Actual, typename Expected>
+auto check_equal(const Actual& actual, const Expected& expected,
+                 const char* const file, const int line,
+                 const char* const what) -> void {
+  if (actual == expected) {
+    return;
+  }
+  fail(file, line, what);
+  if constexpr (::std::convertible_to<const Actual&, ::std::string_view> and
+                ::std::convertible_to<const Expected&, ::std::string_view>) {
+    const ::std::string_view got{actual};
+    const ::std::string_view want{expected};
+    ::std::fprintf(stderr, "  got      \"%.*s\"\n  expected \"%.*s\"\n",
+                   static_cast<int>(got.size()), got.data(),
+                   static_cast<int>(want.size()), want.data());
+  }
+}
+
+}  // namespace fmt::test
+
+#define FORMAT_TEST(name)                                             \
+  static auto name()->void;                                           \
+  static const ::fmt::test::Register name##_registered{#name, &name}; \
+  static auto name()->void
+
+#define CHECK(...)                                         \
+  do {                                                     \
+    if (not(__VA_ARGS__)) {                                \
+      ::fmt::test::fail(__FILE__, __LINE__, #__VA_ARGS__); \
+    }                                                      \
+  } while (false)
+
+#define CHECK_EQ(actual, expected)                                   \
+  ::fmt::test::check_equal((actual), (expected), __FILE__, __LINE__, \
+                           #actual " == " #expected)
+
+#define CHECK_THROWS(type, ...)                                \
+  do {                                                         \
+    try {                                                      \
+      static_cast<void>(__VA_ARGS__);                          \
+      ::fmt::test::fail(__FILE__, __LINE__,                    \
+                        #__VA_ARGS__ " did not throw " #type); \
+    } catch (const type&) {                                    \
+    }                                                          \
+  } while (false)
+
+#endif  // FORMAT_TESTS_CHECK_HPP_
@@ -0,0 +1,54 @@
+#include <iterator>
+#include <string>
+
+#include "check.hpp"
+#include "format/compile.hpp"
+#include "format/format.hpp"
+
+// Compiled format strings.
+
+static_assert(fmt::format(fmt::compile<"{:#x}">, 255) == "0xff");
+static_assert(fmt::format(fmt::compile<"[{:>4}]">, "ab") == "[  ab]");
+static_assert(fmt::formatted_size(fmt::compile<"{} {}">, 10, "abc") == 6);
+
+namespace {
+
+struct Tag {
+  static inline int prints_{0};
+};
+
+}  // namespace
+
+template <>
+struct fmt::Formatter<Tag> {
+  static auto buf_print(Buffer& str, const Tag&, const FormatSpecifier&)
+      -> void {
+    ++Tag::prints_;
+    str.append("tag");
+  }
+};
+
+FORMAT_TEST(compiled_matches_checked) {
+  CHECK_EQ(fmt::format(fmt::compile<"{} took {}us">, "parse", 42),
+           fmt::format("{} took {}us", "parse", 42));
+  CHECK_EQ(fmt::format(fmt::compile<"{1}{0}">, 1, 2), "21");
+  CHECK_EQ(fmt::format(fmt::compile<"{:.3f}|{:>{}}">, 2.0, 'x', 3),
+           fmt::format("{:.3f}|{:>{}}", 2.0, 'x', 3));
+  CHECK_EQ(fmt::format(fmt::compile<"no fields">), "no fields");
+}
+
+FORMAT_TEST(compiled_outputs) {
+  fmt::MemoryBuffer<> buf{};
+  fmt::format_to(buf, fmt::compile<"{}-{}">, 1, "a");
+  CHECK_EQ(buf.view(), "1-a");
+  std::string out{};
+  fmt::format_to(std::back_inserter(out), fmt::compile<"{:b}">, 5);
+  CHECK_EQ(out, "101");
+  CHECK_EQ(fmt::formatted_size(fmt::compile<"{:08.3f}">, 1.5), 8U);
+}
+
+FORMAT_TEST(compiled_format_writes_each_argument_once) {
+  Tag::prints_ = 0;
+  CHECK_EQ(fmt::format(fmt::compile<"<{}>">, Tag{}), "<tag>");
+  CHECK_EQ(Tag::prints_, 1);
+}
@@ -0,0 +1,13 @@
+// A translation unit built against format_core, whose object
+// tests/core_symbols.cmake inspects: the builtin formatters must be
+// referenced, not compiled into it.
+
+#include <string>
+
+#include "format/compile.hpp"
+
+auto format_core_consumer(const fmt::i16 a, const fmt::u64 b, const double c)
+    -> std::string {
+  const auto size{fmt::formatted_size(fmt::compile<"{}">, c)};
+  return fmt::format(fmt::compile<"{} {:#x} {:.3f} {:>8}">, a, b, c, size);
+}
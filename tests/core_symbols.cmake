@@ -0,0 +1,46 @@
+# Checks that an object compiled against format_core takes the builtin
+# integer and float formatters from the library rather than instantiating
+# them itself.
+#
+#   cmake -DNM=nm -DOBJECTS=<object files> -P core_symbols.cmake
+
+foreach(required NM OBJECTS)
+  if(NOT DEFINED ${required})
+    message(FATAL_ERROR "core_symbols: ${required} is not set")
+  endif()
+endforeach()
+
+execute_process(
+    COMMAND ${NM} -C ${OBJECTS}
+    OUTPUT_VARIABLE symbols
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "core_symbols: ${NM} failed")
+endif()
+
+# The constexpr `buf_print` and integer `size_hint` only dispatch and may be
+# emitted anywhere; the kernels behind them must not.
+set(kernel "(Integer|Float)Formatter<[^>]*>::(write|measure|print|size)")
+set(float_size "FloatFormatter<[^>]*>::size_hint")
+string(REGEX MATCHALL "[^\n]* [TtWw] fmt::detail::${kernel}\\([^\n]*"
+    defined "${symbols}")
+string(REGEX MATCHALL "[^\n]* [TtWw] fmt::detail::${float_size}\\([^\n]*"
+    float_sizes "${symbols}")
+list(APPEND defined ${float_sizes})
+if(defined)
+  string(REPLACE ";" "\n" defined "${defined}")
+  message(FATAL_ERROR "core_symbols: instantiated in the consumer:\n${defined}")
+endif()
+
+foreach(expected
+    "IntegerFormatter<short>::write"
+    "IntegerFormatter<unsigned long>::write"
+    "FloatFormatter<double>::write"
+    "FloatFormatter<double>::size_hint")
+  string(FIND "${symbols}" " U fmt::detail::${expected}(" found)
+  if(found EQUAL -1)
+    message(FATAL_ERROR "core_symbols: ${expected} is not taken from the "
+        "library")
+  endif()
+endforeach()
+message(STATUS "core_symbols: builtin formatters come from format_core")
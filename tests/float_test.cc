@@ -0,0 +1,61 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "check.hpp"
+#include "format/format.hpp"
+
+// Shortest round-trip floats, and the precision types.
+
+FORMAT_TEST(shortest_round_trip) {
+  CHECK_EQ(fmt::format("{}", 0.1), "0.1");
+  CHECK_EQ(fmt::format("{}", 1.5F), "1.5");
+  CHECK_EQ(fmt::format("{}", 100.0), "100");
+  CHECK_EQ(fmt::format("{}", -0.0), "-0");
+  CHECK_EQ(fmt::format("{}", 1e16), "1e+16");
+  CHECK_EQ(fmt::format("{}", 1e-5), "1e-05");
+  CHECK_EQ(fmt::format("{}", std::numeric_limits<double>::max()),
+           "1.7976931348623157e+308");
+  CHECK_EQ(fmt::format("{}", std::numeric_limits<double>::denorm_min()),
+           "5e-324");
+
+  // Bit patterns spread over the whole range parse back to themselves.
+  std::uint64_t bits{0x9E3779B97F4A7C15};
+  for (int i = 0; i < 2000; ++i) {
+    bits = bits * 6364136223846793005U + 1442695040888963407U;
+    double value{};
+    std::memcpy(&value, &bits, sizeof(value));
+    if (not std::isfinite(value)) {
+      continue;
+    }
+    const auto text{fmt::format("{}", value)};
+    CHECK(std::strtod(text.c_str(), nullptr) == value);
+    CHECK_EQ(fmt::formatted_size("{}", value), text.size());
+  }
+}
+
+FORMAT_TEST(float_types_and_precision) {
+  CHECK_EQ(fmt::format("{:.2f}", 3.14159), "3.14");
+  CHECK_EQ(fmt::format("{:f}", 1.0), "1.000000");
+  CHECK_EQ(fmt::format("{:e}|{:.3e}", 12345.678, 12345.678),
+           "1.234568e+04|1.235e+04");
+  CHECK_EQ(fmt::format("{:E}", 1.5), "1.500000E+00");
+  CHECK_EQ(fmt::format("{:g}|{:.3g}", 0.0001, 1234.5), "0.0001|1.23e+03");
+  CHECK_EQ(fmt::format("{:a}|{:A}", 1.0, 0.5), "1p+0|1P-1");
+  CHECK_EQ(fmt::format("{:#.0f}", 2.0), "2.");
+  CHECK_EQ(fmt::format("{:.{}f}", 2.0 / 3, 3), "0.667");
+}
+
+FORMAT_TEST(float_special_values_and_padding) {
+  constexpr auto Inf{std::numeric_limits<double>::infinity()};
+  CHECK_EQ(fmt::format("{}|{}|{:F}", Inf, -Inf, Inf), "inf|-inf|INF");
+  CHECK_EQ(fmt::format("{}", std::nan("")), "nan");
+  CHECK_EQ(fmt::format("[{:+08.2f}]", 3.14159), "[+0003.14]");
+  CHECK_EQ(fmt::format("[{:>10}]", 2.5), "[       2.5]");
+  CHECK_EQ(fmt::format("[{:*^9}]", 1.5), "[***1.5***]");
+  CHECK_EQ(fmt::format("[{:010.3e}]", -1.0), "[-1.000e+00]");
+  CHECK_EQ(fmt::formatted_size("{:+08.2f}", 3.14159), 8U);
+}
@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include "check.hpp"
+#include "format/compile.hpp"
+#include "format/format.hpp"
+#include "format/print.hpp"
+#include "format/ranges.hpp"
+#include "format/runtime.hpp"
+
+// The format string is parsed once, at compile time.
+
+static_assert(fmt::format("{} and {}", 1, 2) == "1 and 2");
+static_assert(fmt::FormatString<int, int>{"{} {}"}.segments().size() == 2);
+
+FORMAT_TEST(segment_table_is_sized_by_arity) {
+  // One segment per argument plus a fixed allowance, not three per argument.
+  using Ten = fmt::FormatString<int, int, int, int, int, int, int, int, int,
+                                int>;
+  CHECK(sizeof(Ten) <
+        sizeof(fmt::FormatSegment) * (10 + Ten::SpareFields) + 64);
+  CHECK(fmt::FormatString<int>::MaxFields == 1 + Ten::SpareFields);
+  CHECK(fmt::FormatString<>::MaxFields == 0);
+}
+
+FORMAT_TEST(argument_reused) {
+  // Every field is in the table, none is parsed again when formatting.
+  constexpr fmt::FormatString<int> Fmt{"{0}-{0}-{0}-{0}-{0:x}"};
+  static_assert(Fmt.segments().size() == 5);
+  CHECK_EQ(fmt::format("{0}-{0}-{0}-{0}-{0:x}", 26), "26-26-26-26-1a");
+  CHECK_EQ(fmt::formatted_size("{0}-{0}-{0}-{0}-{0:x}", 26), 14U);
+  CHECK_EQ(fmt::format("[{0}|{1}|{0}|{1}|{0:>{1}}]", 7, 3),
+           "[7|3|7|3|  7]");
+  CHECK_EQ(fmt::format(fmt::compile<"{0}{0}{0}{0}{0}">, 5), "55555");
+}
+
+FORMAT_TEST(literal_text_around_fields) {
+  CHECK_EQ(fmt::format("no fields"), "no fields");
+  CHECK_EQ(fmt::format("{}", 1), "1");
+  CHECK_EQ(fmt::format("a{}b{}c", 1, 2), "a1b2c");
+  CHECK_EQ(fmt::format("{1}{0}", 1, 2), "21");
+}
+
+// formatted_size, and format writing every argument once.
+
+namespace {
+
+struct Counted {
+  static inline int prints_{0};
+};
+
+}  // namespace
+
+template <>
+struct fmt::Formatter<Counted> {
+  static auto buf_print(Buffer& str, const Counted&, const FormatSpecifier&)
+      -> void {
+    ++Counted::prints_;
+    str.append("counted");
+  }
+};
+
+FORMAT_TEST(formatted_size_matches_format) {
+  CHECK_EQ(fmt::formatted_size("{} {}", 1234, "abc"), 8U);
+  CHECK_EQ(fmt::formatted_size("{:>8}|{:x}", "ab", 255), 11U);
+  CHECK_EQ(fmt::formatted_size("{}", 1.5), fmt::format("{}", 1.5).size());
+  CHECK_EQ(fmt::formatted_size("{}", Counted{}), 7U);
+}
+
+FORMAT_TEST(format_writes_each_argument_once) {
+  Counted::prints_ = 0;
+  CHECK_EQ(fmt::format("{} and {}", Counted{}, 2.5), "counted and 2.5");
+  CHECK_EQ(Counted::prints_, 1);
+  const std::string long_text(600, 'x');
+  CHECK_EQ(fmt::format("{}{}", Counted{}, long_text).size(), 607U);
+  CHECK_EQ(Counted::prints_, 2);
+}
+
+// Format strings without arguments.
+
+static_assert(fmt::format("plain") == "plain");
+static_assert(fmt::FormatString<>::Arity == 0);
+static_assert(fmt::FormatArgs<>::Arity == 0);
+
+FORMAT_TEST(zero_arguments) {
+  CHECK_EQ(fmt::format(""), "");
+  CHECK_EQ(fmt::formatted_size("no fields"), 9U);
+  CHECK_EQ(fmt::format(fmt::compile<"compiled">), "compiled");
+  CHECK_EQ(fmt::formatted_size(fmt::compile<"">), 0U);
+  std::string out{};
+  fmt::format_to(std::back_inserter(out), "to {}", "it");
+  fmt::format_to(std::back_inserter(out), "!");
+  CHECK_EQ(out, "to it!");
+  CHECK_EQ(fmt::format("{}", std::tuple<>{}), "()");
+  CHECK_EQ(fmt::format("{:n}", std::tuple<>{}), "");
+
+  std::FILE* const file{std::tmpfile()};
+  fmt::print(file, "line\n");
+  std::rewind(file);
+  char text[8]{};
+  CHECK_EQ(std::fread(text, 1, sizeof(text), file), 5U);
+  CHECK_EQ(std::string_view{text}, "line\n");
+  std::fclose(file);
+}
+
+// The builtin formatters and the runtime engine, compiled once in
+// format_core when the tests are linked against it.
+
+#if defined(FORMAT_CORE_LIBRARY)
+static_assert(FORMAT_DEFINE_CORE == 0);
+#else
+static_assert(FORMAT_DEFINE_CORE == 1);
+#endif
+
+FORMAT_TEST(core_formatters) {
+  CHECK_EQ(fmt::format("{} {} {} {}", fmt::i16{-1}, fmt::i32{-2},
+                       fmt::i64{-3}, fmt::u16{4}),
+           "-1 -2 -3 4");
+  CHECK_EQ(fmt::format("{:x} {:#o}", fmt::u32{255}, fmt::u64{8}), "ff 010");
+  CHECK_EQ(fmt::format("{} {:.2f}", fmt::f32{0.5F}, fmt::f64{2.0}),
+           "0.5 2.00");
+  CHECK_EQ(fmt::formatted_size("{:>6}", fmt::f64{1.25}), 6U);
+  const auto args{fmt::make_format_args(fmt::i64{7}, "x")};
+  CHECK_EQ(fmt::vformat("{1}{0}", args.view()), "x7");
+}
+
+// Checked calls share one runtime engine; constant evaluation runs
+// the same loop inline.
+
+namespace {
+
+constexpr auto padded(const int value) -> std::string {
+  return fmt::format("[{:>5}|{:<#6x}|{}]", value, value, "s");
+}
+
+}  // namespace
+
+static_assert(padded(42) == "[   42|0x2a  |s]");
+static_assert(fmt::formatted_size("{:>5}|{:<#6x}", 42, 42) == 12);
+
+FORMAT_TEST(engine_matches_constant_evaluation) {
+  int value{42};
+  CHECK_EQ(padded(value), "[   42|0x2a  |s]");
+  CHECK_EQ(fmt::formatted_size("{:>5}|{:<#6x}", value, value), 12U);
+
+  constexpr fmt::FormatString<int, const char*> Fmt{"<{1}:{0:04}>"};
+  const fmt::FormatArgs<int, const char*> args{value, "id"};
+  fmt::MemoryBuffer<> buf{};
+  fmt::detail::vformat_to(buf, Fmt.view(), args.view());
+  CHECK_EQ(buf.view(), "<id:0042>");
+  CHECK_EQ(fmt::detail::vformatted_size(Fmt.view(), args.view()), 9U);
+}
+
+#if FORMAT_HAS_WRITEV
+FORMAT_TEST(print_with_many_fields) {
+  // More fields than write_segments keeps on the stack, each its own
+  // argument, written to a descriptor so the writev path is the one taken.
+  int fds[2];
+  CHECK_EQ(::pipe(fds), 0);
+  fmt::print(fds[1],
+             "{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},"
+             "{},{},{},{},{},{},{},{},{},{},{},{},{},{}!",
+             0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17,
+             18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32,
+             "x");
+  ::close(fds[1]);
+  std::string expected{};
+  for (int i = 0; i < 33; ++i) {
+    expected += std::to_string(i) + ",";
+  }
+  expected += "x!";
+  std::string text{};
+  char chunk[256];
+  while (const auto size{::read(fds[0], chunk, sizeof(chunk))}) {
+    CHECK(size > 0);
+    if (size < 0) {
+      break;
+    }
+    text.append(chunk, static_cast<std::size_t>(size));
+  }
+  ::close(fds[0]);
+  CHECK_EQ(text, expected);
+}
+#endif
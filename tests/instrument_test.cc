@@ -0,0 +1,62 @@
+#include <string>
+#include <thread>
+
+#include "check.hpp"
+#include "format/format.hpp"
+#include "format/instrument.hpp"
+#include "format/runtime.hpp"
+
+// Instrumentation counters, built with FORMAT_ENABLE_INSTRUMENTATION.
+
+static_assert(fmt::instrumentation::Enabled);
+
+FORMAT_TEST(counts_calls_and_bytes) {
+  fmt::instrumentation::reset();
+  CHECK_EQ(fmt::format("{} {}", 1, "abc"), "1 abc");
+  const auto counters{fmt::instrumentation::thread_snapshot()};
+  CHECK_EQ(counters.calls_, 1U);
+  CHECK_EQ(counters.bytes_, 5U);
+  CHECK_EQ(counters.reserve_misses_, 0U);
+  CHECK_EQ(counters.errors_, 0U);
+}
+
+FORMAT_TEST(counts_no_allocation_into_a_buffer) {
+  fmt::MemoryBuffer<> buf{};
+  fmt::instrumentation::reset();
+  fmt::format_to(buf, "{:>8}|{:x}", "ab", 255);
+  const auto counters{fmt::instrumentation::thread_snapshot()};
+  CHECK_EQ(counters.calls_, 1U);
+  CHECK_EQ(counters.bytes_, 11U);
+  CHECK_EQ(counters.allocations_, 0U);
+  CHECK_EQ(counters.regrowths_, 0U);
+}
+
+FORMAT_TEST(counts_regrowth) {
+  fmt::MemoryBuffer<16> buf{};
+  fmt::instrumentation::reset();
+  fmt::format_to(buf, "{}", std::string(100, '.'));
+  const auto counters{fmt::instrumentation::thread_snapshot()};
+  CHECK(counters.regrowths_ >= 1);
+  CHECK(counters.allocations_ >= 1);
+}
+
+FORMAT_TEST(counts_errors) {
+  fmt::instrumentation::reset();
+  CHECK_THROWS(fmt::FormatError, fmt::format(fmt::runtime("{2}"), 1));
+  CHECK_THROWS(fmt::FormatError, fmt::format(fmt::runtime("{:q}"), 1));
+  CHECK_EQ(fmt::instrumentation::thread_snapshot().errors_, 2U);
+}
+
+FORMAT_TEST(snapshot_sums_threads) {
+  fmt::instrumentation::reset();
+  std::thread worker{[] { static_cast<void>(fmt::format("{}", 12)); }};
+  worker.join();
+  static_cast<void>(fmt::format("{}", 3));
+  const auto total{fmt::instrumentation::snapshot()};
+  CHECK_EQ(total.calls_, 2U);
+  CHECK_EQ(total.bytes_, 3U);
+  CHECK_EQ(fmt::instrumentation::thread_snapshot().calls_, 1U);
+
+  fmt::instrumentation::reset();
+  CHECK_EQ(fmt::instrumentation::snapshot().calls_, 0U);
+}
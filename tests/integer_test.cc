@@ -0,0 +1,65 @@
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "check.hpp"
+#include "format/format.hpp"
+
+// Decimal integers.
+
+FORMAT_TEST(decimal_limits) {
+  using std::numeric_limits;
+  CHECK_EQ(fmt::format("{}", 0), "0");
+  CHECK_EQ(fmt::format("{}", numeric_limits<std::int16_t>::min()), "-32768");
+  CHECK_EQ(fmt::format("{}", numeric_limits<int>::min()), "-2147483648");
+  CHECK_EQ(fmt::format("{}", numeric_limits<std::int64_t>::min()),
+           "-9223372036854775808");
+  CHECK_EQ(fmt::format("{}", numeric_limits<std::uint64_t>::max()),
+           "18446744073709551615");
+  CHECK_EQ(fmt::format("{}", numeric_limits<unsigned>::max()),
+           "4294967295");
+}
+
+FORMAT_TEST(decimal_every_length) {
+  std::uint64_t value{1};
+  for (int digits = 1; digits <= 19; ++digits) {
+    CHECK_EQ(fmt::format("{}", value), std::to_string(value));
+    CHECK_EQ(fmt::format("{}", value - 1), std::to_string(value - 1));
+    CHECK_EQ(fmt::formatted_size("{}", value), std::to_string(value).size());
+    value *= 10;
+  }
+}
+
+FORMAT_TEST(decimal_padding_and_sign) {
+  CHECK_EQ(fmt::format("[{:5}]", 42), "[   42]");
+  CHECK_EQ(fmt::format("[{:<5}]", 42), "[42   ]");
+  CHECK_EQ(fmt::format("[{:^6}]", -42), "[ -42  ]");
+  CHECK_EQ(fmt::format("[{:05}]", -42), "[-0042]");
+  CHECK_EQ(fmt::format("[{:+}|{: }|{:-}]", 1, 1, 1), "[+1| 1|1]");
+  CHECK_EQ(fmt::formatted_size("{:+08}", 123), 8U);
+}
+
+// Hexadecimal, octal and binary.
+
+FORMAT_TEST(radix_kernels) {
+  CHECK_EQ(fmt::format("{:x}|{:X}|{:#x}|{:#X}", 255, 255, 255, 255),
+           "ff|FF|0xff|0XFF");
+  CHECK_EQ(fmt::format("{:o}|{:#o}|{:#o}", 8, 8, 0), "10|010|0");
+  CHECK_EQ(fmt::format("{:b}|{:#b}|{:#B}", 5, 5, 5), "101|0b101|0B101");
+  CHECK_EQ(fmt::format("{:x}", -255), "-ff");
+  CHECK_EQ(fmt::format("{:x}", std::numeric_limits<std::int64_t>::min()),
+           "-8000000000000000");
+  CHECK_EQ(fmt::format("{:b}", std::numeric_limits<std::uint64_t>::max()),
+           std::string(64, '1'));
+  CHECK_EQ(fmt::format("{:x}", 0), "0");
+}
+
+FORMAT_TEST(radix_width) {
+  CHECK_EQ(fmt::format("[{:8x}]", 255), "[      ff]");
+  CHECK_EQ(fmt::format("[{:<#8x}]", 255), "[0xff    ]");
+  CHECK_EQ(fmt::format("[{:#010x}]", 255), "[0x000000ff]");
+  CHECK_EQ(fmt::format("[{:+#06b}]", 3), "[+0b011]");
+  CHECK_EQ(fmt::format("[{:*^9o}]", 64), "[***100***]");
+  CHECK_EQ(fmt::formatted_size("{:#010x}", 255), 10U);
+  CHECK_EQ(fmt::formatted_size("{:#b}", 1023), 12U);
+}
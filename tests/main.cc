@@ -0,0 +1,25 @@
+// Runs every FORMAT_TEST linked into the binary; the exit status is the
+// number of failed checks, capped for the shell.
+
+#include <cstdio>
+#include <exception>
+
+#include "check.hpp"
+
+auto main() -> int {
+  for (const auto& test : ::fmt::test::cases()) {
+    const int before{::fmt::test::failures()};
+    try {
+      test.run_();
+    } catch (const ::std::exception& e) {
+      ::fmt::test::fail(test.name_, 0, e.what());
+    }
+    ::std::printf("%s %s\n",
+                  ::fmt::test::failures() == before ? "pass" : "FAIL",
+                  test.name_);
+  }
+  const int failed{::fmt::test::failures()};
+  ::std::printf("%zu tests, %d failed checks\n", ::fmt::test::cases().size(),
+                failed);
+  return failed > 100 ? 100 : failed;
+}
@@ -0,0 +1,54 @@
+#include <array>
+#include <string>
+#include <string_view>
+
+#include "check.hpp"
+#include "format/compile.hpp"
+#include "format/format.hpp"
+
+// Named arguments, resolved to indices when the string is checked.
+
+static_assert(fmt::detail::is_arg_name("user"));
+static_assert(fmt::detail::is_arg_name("_ms2"));
+static_assert(not fmt::detail::is_arg_name("2ms"));
+static_assert(not fmt::detail::is_arg_name(""));
+
+static_assert(fmt::format("{b}{a}", fmt::arg<"a">(1), fmt::arg<"b">(2)) ==
+              "21");
+
+FORMAT_TEST(named_fields) {
+  using namespace fmt::literals;
+  const std::string user{"ann"};
+  CHECK_EQ(fmt::format("{user} took {ms}ms", fmt::arg<"user">(user),
+                       fmt::arg<"ms">(42)),
+           "ann took 42ms");
+  CHECK_EQ(fmt::format("{user} took {ms}ms", "user"_a = user, "ms"_a = 42),
+           "ann took 42ms");
+  CHECK_EQ(fmt::format("{ms:x}/{ms}/{0}", "ms"_a = 255), "ff/255/255");
+  CHECK_EQ(fmt::format("{} {name}", 1, "name"_a = "two"), "1 two");
+  CHECK_EQ(fmt::formatted_size("{user}:{ms:>5}", "user"_a = user,
+                               "ms"_a = 7),
+           9U);
+}
+
+FORMAT_TEST(named_dynamic_width) {
+  using namespace fmt::literals;
+  CHECK_EQ(fmt::format("[{ms:>{w}}]", "ms"_a = 42, "w"_a = 5), "[   42]");
+  CHECK_EQ(fmt::format("[{v:.{p}f}]", "v"_a = 1.25, "p"_a = 1), "[1.2]");
+}
+
+FORMAT_TEST(named_compiled) {
+  using namespace fmt::literals;
+  CHECK_EQ(fmt::format(fmt::compile<"{user}={ms:04}">, "user"_a = "id",
+                       "ms"_a = 7),
+           "id=0007");
+  CHECK_EQ(fmt::formatted_size(fmt::compile<"{user}={ms:04}">,
+                               "user"_a = "id", "ms"_a = 7),
+           7U);
+}
+
+FORMAT_TEST(unknown_name) {
+  constexpr std::array<std::string_view, 2> Names{"user", ""};
+  CHECK_EQ(fmt::detail::named_position("user", Names), 0U);
+  CHECK_THROWS(fmt::FormatError, fmt::detail::named_position("ms", Names));
+}
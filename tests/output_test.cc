@@ -0,0 +1,165 @@
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "check.hpp"
+#include "format/format.hpp"
+
+namespace {
+
+/// @brief Counts the allocations made through it.
+template <typename Type>
+struct CountingAllocator {
+  using value_type = Type;
+
+  CountingAllocator() = default;
+  template <typename Other>
+  CountingAllocator(const CountingAllocator<Other>&) noexcept {}  // NOLINT
+
+  static inline int allocations_{0};
+
+  auto allocate(const std::size_t count) -> Type* {
+    ++allocations_;
+    return std::allocator<Type>{}.allocate(count);
+  }
+  auto deallocate(Type* const ptr, const std::size_t count) noexcept -> void {
+    std::allocator<Type>{}.deallocate(ptr, count);
+  }
+  friend auto operator==(CountingAllocator, CountingAllocator) -> bool {
+    return true;
+  }
+};
+
+}  // namespace
+
+// format_to, format_to_n and format_into.
+
+FORMAT_TEST(format_to_iterators) {
+  std::string line{"> "};
+  fmt::format_to(std::back_inserter(line), "{} + {}", 1, 2);
+  CHECK_EQ(line, "> 1 + 2");
+
+  std::vector<char> chars{};
+  fmt::format_to(std::back_inserter(chars), "{:>4}", "ab");
+  CHECK_EQ(std::string_view(chars.data(), chars.size()), "  ab");
+
+  std::list<char> list{};
+  fmt::format_to(std::back_inserter(list), "{}", 42);
+  CHECK_EQ(std::string(list.begin(), list.end()), "42");
+
+  // Longer than the iterator buffer's chunk.
+  std::deque<char> deque{};
+  const std::string long_text(1000, 'z');
+  fmt::format_to(std::back_inserter(deque), "{}{}", long_text, 7);
+  CHECK_EQ(deque.size(), 1001U);
+  CHECK_EQ(deque.back(), '7');
+
+  char raw[16]{};
+  char* const end{fmt::format_to(raw, "{}-{}", "a", 9)};
+  CHECK_EQ(std::string_view(raw, end), "a-9");
+}
+
+FORMAT_TEST(format_to_n_truncates) {
+  char frame[8]{};
+  const auto result{fmt::format_to_n(frame, 4, "{}", "a long message")};
+  CHECK_EQ(result.size_, 14);
+  CHECK_EQ(std::string_view(frame, result.out_), "a lo");
+
+  std::string out{};
+  const auto into_string{
+      fmt::format_to_n(std::back_inserter(out), 3, "{}{}", 12345, "x")};
+  CHECK_EQ(out, "123");
+  CHECK_EQ(into_string.size_, 6);
+
+  const auto nothing{fmt::format_to_n(frame, 0, "{}", 1)};
+  CHECK(nothing.out_ == frame);
+  CHECK_EQ(nothing.size_, 1);
+}
+
+FORMAT_TEST(format_into_span) {
+  std::array<char, 6> frame{};
+  const auto fits{fmt::format_into(std::span<char>{frame}, "{}", 42)};
+  CHECK_EQ(std::string_view(frame.data(), fits.out_), "42");
+  const auto cut{fmt::format_into(std::span<char>{frame}, "{:08x}", 255)};
+  CHECK_EQ(std::string_view(frame.data(), cut.out_), "000000");
+  CHECK_EQ(cut.size_, 8);
+}
+
+// MemoryBuffer, inline storage first.
+
+FORMAT_TEST(memory_buffer_stays_inline) {
+  using Allocator = CountingAllocator<char>;
+  Allocator::allocations_ = 0;
+  fmt::MemoryBuffer<64, Allocator> buf{};
+  fmt::format_to(buf, "{}: {}", "id", 42);
+  CHECK_EQ(buf.view(), "id: 42");
+  CHECK_EQ(buf.capacity(), 64U);
+  CHECK_EQ(Allocator::allocations_, 0);
+  buf.clear();
+  CHECK_EQ(buf.size(), 0U);
+}
+
+FORMAT_TEST(memory_buffer_grows_and_moves) {
+  using Allocator = CountingAllocator<char>;
+  Allocator::allocations_ = 0;
+  fmt::MemoryBuffer<16, Allocator> buf{};
+  const std::string text(100, 'q');
+  fmt::format_to(buf, "{}|{}", text, 1);
+  CHECK_EQ(buf.view(), text + "|1");
+  const auto allocations{Allocator::allocations_};
+  CHECK(allocations >= 1 and allocations <= 2);
+
+  // Heap storage changes hands.
+  fmt::MemoryBuffer<16, Allocator> moved{std::move(buf)};
+  CHECK_EQ(moved.view(), text + "|1");
+  CHECK_EQ(buf.size(), 0U);
+  CHECK_EQ(Allocator::allocations_, allocations);
+
+  fmt::MemoryBuffer<16> small{};
+  small.append("abc");
+  fmt::MemoryBuffer<16> small_moved{std::move(small)};
+  CHECK_EQ(small_moved.str(), "abc");
+}
+
+// Allocator-aware and std::pmr formatting.
+
+FORMAT_TEST(format_with_an_allocator) {
+  using Allocator = CountingAllocator<char>;
+  const std::string text(40, 'a');
+  Allocator::allocations_ = 0;
+  const auto line{
+      fmt::format(std::allocator_arg, Allocator{}, "{} {}", text, 12345)};
+  CHECK_EQ(std::string_view{line}, text + " 12345");
+  CHECK_EQ(Allocator::allocations_, 1);
+
+  Allocator::allocations_ = 0;
+  const auto floats{
+      fmt::format(std::allocator_arg, Allocator{}, "{} {}", text, 0.5)};
+  CHECK_EQ(std::string_view{floats}, text + " 0.5");
+  CHECK_EQ(Allocator::allocations_, 1);
+}
+
+FORMAT_TEST(format_into_a_memory_resource) {
+  std::array<std::byte, 1024> arena{};
+  // Anything not served from the arena throws.
+  std::pmr::monotonic_buffer_resource resource{
+      arena.data(), arena.size(), std::pmr::null_memory_resource()};
+  const std::string text(100, 'b');
+  const std::pmr::string line{fmt::format(&resource, "{}:{}", text, 1.25)};
+  CHECK_EQ(std::string_view{line}, text + ":1.25");
+  CHECK(line.get_allocator().resource() == &resource);
+
+  fmt::pmr::MemoryBuffer<16> buf{&resource};
+  fmt::format_to(buf, "{}", text);
+  CHECK_EQ(buf.view(), text);
+  CHECK(buf.get_allocator().resource() == &resource);
+}
@@ -0,0 +1,72 @@
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "format/compile.hpp"
+#include "format/parallel.hpp"
+
+// Formatting a large range on several threads.
+
+namespace {
+
+auto serial(const std::vector<int>& values, const std::string_view separator)
+    -> std::string {
+  std::string out{};
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (i not_eq 0) {
+      out += separator;
+    }
+    out += fmt::format("<{:x}>", values[i]);
+  }
+  return out;
+}
+
+}  // namespace
+
+FORMAT_TEST(parallel_matches_serial) {
+  std::vector<int> values(10000);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<int>(i * 7919);
+  }
+  const auto expected{serial(values, ", ")};
+  for (const std::size_t threads : {1U, 2U, 3U, 8U}) {
+    CHECK_EQ(fmt::format_range_parallel("<{:x}>", values, ", ", threads),
+             expected);
+    CHECK_EQ(fmt::format_range_parallel(fmt::compile<"<{:x}>">, values, ", ",
+                                        threads),
+             expected);
+  }
+  CHECK_EQ(fmt::format_range_parallel("{}", std::vector<int>{}, ","), "");
+  CHECK_EQ(fmt::format_range_parallel("{}", std::vector<int>{1, 2}, ","),
+           "1,2");
+}
+
+FORMAT_TEST(parallel_for_runs_every_index_once) {
+  for (int round = 0; round < 50; ++round) {
+    std::vector<std::atomic<int>> runs(5);
+    fmt::detail::parallel_for(runs.size(), [&](const std::size_t index) {
+      runs[index].fetch_add(1);
+      // A nested call runs on the calling thread.
+      fmt::detail::parallel_for(2, [](std::size_t) {});
+    });
+    for (const auto& count : runs) {
+      CHECK_EQ(count.load(), 1);
+    }
+  }
+}
+
+FORMAT_TEST(parallel_for_rethrows) {
+  CHECK_THROWS(std::runtime_error,
+               fmt::detail::parallel_for(4, [](const std::size_t index) {
+                 if (index == 2) {
+                   throw std::runtime_error{"chunk"};
+                 }
+               }));
+  int calls{0};
+  fmt::detail::parallel_for(3, [&](std::size_t) {});
+  fmt::detail::parallel_for(1, [&](std::size_t) { ++calls; });
+  CHECK_EQ(calls, 1);
+}
@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include "check.hpp"
+#include "format/print.hpp"
+#include "format/runtime.hpp"
+
+// Printing to a std::ostream.
+
+FORMAT_TEST(ostream_print) {
+  std::ostringstream stream{};
+  stream << "a ";
+  fmt::print(stream, "{} {:>3}", 1, "b");
+  fmt::print(stream, fmt::runtime("|{}"), 2.5);
+  CHECK_EQ(stream.str(), "a 1   b|2.5");
+
+  // Longer than the stream's put area and the inline buffer.
+  std::ostringstream long_stream{};
+  const std::string text(5000, 'y');
+  fmt::print(long_stream, "<{}>", text);
+  CHECK_EQ(long_stream.str(), "<" + text + ">");
+}
+
+FORMAT_TEST(ostream_print_respects_the_stream_state) {
+  std::ostringstream stream{};
+  stream.setstate(std::ios_base::failbit);
+  fmt::print(stream, "{}", 1);
+  stream.clear();
+  CHECK_EQ(stream.str(), "");
+}
+
+// Printing to file descriptors and C streams.
+
+namespace {
+
+auto contents(std::FILE* const file) -> std::string {
+  std::fflush(file);
+  std::rewind(file);
+  std::string text{};
+  char chunk[4096];
+  while (const auto size{std::fread(chunk, 1, sizeof(chunk), file)}) {
+    text.append(chunk, size);
+  }
+  return text;
+}
+
+}  // namespace
+
+FORMAT_TEST(file_print_keeps_stdio_order) {
+  std::FILE* const file{std::tmpfile()};
+  CHECK(file not_eq nullptr);
+  std::fputs("a ", file);
+  fmt::print(file, "{} {}", 1, "b");
+  std::fputs(" c ", file);
+  fmt::print(file, fmt::runtime("{}|{:>3}"), 2, "d");
+  CHECK_EQ(contents(file), "a 1 b c 2|  d");
+  std::fclose(file);
+}
+
+FORMAT_TEST(file_print_longer_than_the_stream_buffer) {
+  for (const int mode : {_IOFBF, _IOLBF, _IONBF}) {
+    std::FILE* const file{std::tmpfile()};
+    CHECK(std::setvbuf(file, nullptr, mode, 64) == 0);
+    const std::string text(10000, 'x');
+    fmt::print(file, "<{}>\n", text);
+    fmt::print(file, fmt::runtime("{}"), "end");
+    CHECK_EQ(contents(file), "<" + text + ">\nend");
+    std::fclose(file);
+  }
+}
+
+FORMAT_TEST(file_print_reports_failed_writes) {
+  if (std::FILE* const full{std::fopen("/dev/full", "w")}) {
+    std::setvbuf(full, nullptr, _IONBF, 0);
+    CHECK_THROWS(std::system_error, fmt::print(full, "{}", 1));
+    CHECK_THROWS(std::system_error, fmt::print(full, fmt::runtime("{}"), 1));
+    std::fclose(full);
+  }
+}
+
+#if FORMAT_HAS_WRITEV
+FORMAT_TEST(fd_print) {
+  std::FILE* const file{std::tmpfile()};
+  const int fd{fileno(file)};
+  fmt::print(fd, "{}-{}", "fd", 1);
+  fmt::print(fd, fmt::runtime("{:x}"), 255);
+  CHECK_EQ(contents(file), "fd-1ff");
+  std::fclose(file);
+  CHECK_THROWS(std::system_error, fmt::print(-1, "{}", 1));
+}
+#endif
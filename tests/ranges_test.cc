@@ -0,0 +1,90 @@
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "format/format.hpp"
+#include "format/ranges.hpp"
+
+// Ranges, maps, tuples, optionals and fmt::join.
+
+FORMAT_TEST(sequences) {
+  const std::vector<int> values{10, 11, 12};
+  CHECK_EQ(fmt::format("{}", values), "[10, 11, 12]");
+  CHECK_EQ(fmt::format("{::#x}", values), "[0xa, 0xb, 0xc]");
+  CHECK_EQ(fmt::format("{:n}", values), "10, 11, 12");
+  CHECK_EQ(fmt::format("{}", std::vector<int>{}), "[]");
+  CHECK_EQ(fmt::formatted_size("{}", values), 12U);
+  CHECK_EQ(fmt::format("{}", std::set<int>{3, 1}), "{1, 3}");
+}
+
+FORMAT_TEST(maps) {
+  const std::map<int, int> map{{1, 2}, {3, 4}};
+  CHECK_EQ(fmt::format("{}", map), "{1: 2, 3: 4}");
+  CHECK_EQ(fmt::format("{::x}", std::map<int, int>{{10, 11}}), "{a: b}");
+  CHECK_EQ(fmt::format("{}", std::map<std::string, int>{{"k", 1}}),
+           R"({"k": 1})");
+  CHECK_EQ(fmt::formatted_size("{}", map), 12U);
+}
+
+FORMAT_TEST(tuples_and_optionals) {
+  CHECK_EQ(fmt::format("{}", std::tuple{1, "a"}), R"((1, "a"))");
+  CHECK_EQ(fmt::format("{}", std::pair<const int, int>{1, 2}), "(1, 2)");
+  CHECK_EQ(fmt::format("{}", std::optional<int>{}), "none");
+  CHECK_EQ(fmt::format("{}", std::optional<int>{5}), "optional(5)");
+}
+
+FORMAT_TEST(join) {
+  const std::vector<int> values{10, 11, 12};
+  CHECK_EQ(fmt::format("{:x}", fmt::join(values, "|")), "a|b|c");
+  CHECK_EQ(fmt::formatted_size("{:>3}", fmt::join(values, "; ")), 13U);
+  static_assert(
+      fmt::detail::HasCheapSize<decltype(fmt::join(values, ", "))>);
+  CHECK_EQ(fmt::format("{}", fmt::join(std::vector<int>{}, ", ")), "");
+}
+
+FORMAT_TEST(padding) {
+  const std::vector<int> values{1, 2};
+  CHECK_EQ(fmt::format("{:>10}", values), "    [1, 2]");
+  CHECK_EQ(fmt::format("{:*^10}", values), "**[1, 2]**");
+  CHECK_EQ(fmt::format("{:8}|", values), "[1, 2]  |");
+  CHECK_EQ(fmt::format("{:>8}", std::tuple{1, 2}), "  (1, 2)");
+  CHECK_EQ(fmt::format("{:>8}", std::map<int, int>{{1, 2}}), "  {1: 2}");
+  CHECK_EQ(fmt::formatted_size("{:>10}", values), 10U);
+  CHECK_EQ(fmt::formatted_size("{:>8}", std::pair{1, 2}), 8U);
+}
+
+FORMAT_TEST(char_elements) {
+  const std::vector<char> chars{'a', '\'', '\n'};
+  CHECK_EQ(fmt::format("{}", chars), R"(['a', '\'', '\n'])");
+  CHECK_EQ(fmt::formatted_size("{}", chars), 17U);
+  CHECK_EQ(fmt::format("{::c}", std::vector<char>{'a', 'b'}), "[a, b]");
+  CHECK_EQ(fmt::format("{::d}", std::vector<char>{'a'}), "[97]");
+  CHECK_EQ(fmt::format("{}", std::tuple{'x', 1}), "('x', 1)");
+  CHECK_EQ(fmt::format("{}", std::map<char, int>{{'k', 1}}), "{'k': 1}");
+}
+
+FORMAT_TEST(string_elements) {
+  const std::vector<std::string> words{"a b", "say \"hi\"\n"};
+  CHECK_EQ(fmt::format("{}", words), R"(["a b", "say \"hi\"\n"])");
+  CHECK_EQ(fmt::formatted_size("{}", words), 23U);
+  CHECK_EQ(fmt::format("{::s}", words), "[a b, say \"hi\"\n]");
+  CHECK_EQ(fmt::format("{::>5.2}", std::vector<std::string_view>{"abc"}),
+           R"([ "ab"])");
+  CHECK_EQ(fmt::format("{}", std::tuple{'\'', "'"}), R"(('\'', "'"))");
+}
+
+FORMAT_TEST(padding_counts_columns) {
+  const std::vector<std::string> words{"日本"};
+  CHECK_EQ(fmt::format("{:>10}", words), R"(  ["日本"])");
+  CHECK_EQ(fmt::formatted_size("{:>10}", words), 12U);
+  std::vector<int> many(100, 7);
+  const auto text{fmt::format("{:*>400}", many)};
+  CHECK_EQ(text.size(), 400U);
+  CHECK_EQ(text.substr(98, 4), "**[7");
+  CHECK_EQ(fmt::format("{:_^12}", std::pair{"é", 1}), R"(__("é", 1)__)");
+}
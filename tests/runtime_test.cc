@@ -0,0 +1,96 @@
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "format/format.hpp"
+#include "format/ranges.hpp"
+#include "format/runtime.hpp"
+
+// Runtime format strings.
+
+FORMAT_TEST(runtime_format) {
+  const std::string tpl{"{0} {1} took {2}us"};
+  CHECK_EQ(fmt::format(fmt::runtime(tpl), "GET", "/", 42), "GET / took 42us");
+  CHECK_EQ(fmt::format(fmt::runtime("{:>{}}|{:.2f}"), "a", 3, 1.5),
+           "  a|1.50");
+  const auto args{fmt::make_format_args(1, "two")};
+  CHECK_EQ(fmt::vformat("{} {}", args.view()), "1 two");
+  std::string out{};
+  fmt::format_to(std::back_inserter(out), fmt::runtime("<{:x}>"), 255);
+  CHECK_EQ(out, "<ff>");
+}
+
+FORMAT_TEST(runtime_format_long_literals) {
+  // Fields at every offset of the vector brace scan.
+  for (std::size_t prefix = 0; prefix < 70; ++prefix) {
+    const std::string text(prefix, '.');
+    CHECK_EQ(fmt::format(fmt::runtime(text + "{}" + text), 7),
+             text + "7" + text);
+  }
+}
+
+FORMAT_TEST(runtime_format_errors) {
+  CHECK_THROWS(fmt::FormatError, fmt::format(fmt::runtime("{2}"), 1));
+  CHECK_THROWS(fmt::FormatError, fmt::format(fmt::runtime("{"), 1));
+  CHECK_THROWS(fmt::FormatError, fmt::format(fmt::runtime("{:q}"), 1));
+  CHECK_THROWS(fmt::FormatError,
+               fmt::format(fmt::runtime("{:>{}}"), "a", "b"));
+}
+
+// Parsed and cached runtime format strings.
+
+FORMAT_TEST(parsed_format_copies_keep_their_own_text) {
+  const std::vector<int> values{10, 11};
+  auto original{std::make_unique<fmt::ParsedFormat>("{::x}")};
+  const fmt::ParsedFormat copy{*original};
+  original.reset();
+  fmt::MemoryBuffer<> out{};
+  copy.format(out, fmt::make_format_args(values).view());
+  CHECK_EQ(out.view(), "[a, b]");
+}
+
+FORMAT_TEST(parsed_format_moves_keep_their_own_text) {
+  const std::vector<int> values{10, 11};
+  fmt::ParsedFormat source{"{::#x}"};
+  fmt::ParsedFormat moved{std::move(source)};
+  source = fmt::ParsedFormat{"{}"};
+  fmt::MemoryBuffer<> out{};
+  moved.format(out, fmt::make_format_args(values).view());
+  CHECK_EQ(out.view(), "[0xa, 0xb]");
+
+  fmt::ParsedFormat assigned{"{}"};
+  assigned = moved;
+  moved = fmt::ParsedFormat{"{}"};
+  out.clear();
+  assigned.format(out, fmt::make_format_args(values).view());
+  CHECK_EQ(out.view(), "[0xa, 0xb]");
+}
+
+FORMAT_TEST(format_cache_reuses_parses) {
+  fmt::FormatCache cache{4};
+  const std::string tpl{"{} + {} = {}"};
+  for (int i = 0; i < 3; ++i) {
+    CHECK_EQ(fmt::format(fmt::runtime(tpl, cache), i, 1, i + 1),
+             fmt::format("{} + {} = {}", i, 1, i + 1));
+  }
+  const auto stats{cache.stats()};
+  CHECK_EQ(stats.hits_, 2U);
+  CHECK_EQ(stats.misses_, 1U);
+  CHECK_EQ(stats.size_, 1U);
+  CHECK_EQ(stats.capacity_, 4U);
+  CHECK(cache.find(tpl) not_eq nullptr);
+  CHECK_THROWS(fmt::FormatError, cache.find("{"));
+
+  // Past capacity, strings are still formatted, just not cached.
+  for (int i = 0; i < 10; ++i) {
+    const auto digit{std::to_string(i)};
+    CHECK_EQ(fmt::format(fmt::runtime(digit + "{}", cache), i),
+             digit + digit);
+  }
+  CHECK(cache.stats().size_ <= 4U);
+  cache.clear();
+  CHECK_EQ(cache.stats().size_, 0U);
+}
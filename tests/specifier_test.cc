@@ -0,0 +1,92 @@
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "format/format.hpp"
+#include "format/ranges.hpp"
+#include "format/runtime.hpp"
+#include "format/specifier.hpp"
+
+// The [[fill]align][sign][#][0][width][.precision][type] grammar.
+
+static_assert(sizeof(fmt::FormatSpecifier) <= 16);
+
+namespace {
+
+constexpr auto Spec{fmt::FormatSpecifier{"*^+#010.3X"}};
+static_assert(Spec.fill() == '*');
+static_assert(Spec.align() == fmt::Align::Center);
+static_assert(Spec.sign() == fmt::Sign::Plus);
+static_assert(Spec.is_alternate() and Spec.is_zero_padded());
+static_assert(Spec.width() == 10 and Spec.precision() == 3);
+static_assert(Spec.is_hex() and Spec.is_upper());
+static_assert(fmt::FormatSpecifier{"::x"}.nested() == ":x");
+
+// A field's specifier keeps its element specifier as an offset into the
+// field until bound.
+constexpr fmt::FormatString<std::vector<int>> Ranged{"<{:n:#x}>"};
+static_assert(Ranged.segments()[0].specifier_.nested().empty());
+static_assert(Ranged.segments()[0].specifier(Ranged.get_fmt()).nested() ==
+              "#x");
+
+}  // namespace
+
+FORMAT_TEST(fill_and_align) {
+  CHECK_EQ(fmt::format("[{:*^10}]", "mid"), "[***mid****]");
+  CHECK_EQ(fmt::format("[{:<5}|{:>5}]", 1, "a"), "[1    |    a]");
+  CHECK_EQ(fmt::format("[{:>5}|{:<5}]", "a", 1), "[    a|1    ]");
+  CHECK_EQ(fmt::format("[{:-^7}]", -3), "[---3---]");
+  CHECK_EQ(fmt::format("[{:x<4x}]", 255), "[ffxx]");
+}
+
+FORMAT_TEST(sign_alternate_zero) {
+  CHECK_EQ(fmt::format("{:+#010x}", 255), "+0x00000ff");
+  CHECK_EQ(fmt::format("{: d}|{: d}", 5, -5), " 5|-5");
+  CHECK_EQ(fmt::format("{:<06}", 7), "7     ");
+  CHECK_EQ(fmt::format("{:.3}", "abcdef"), "abc");
+  CHECK_EQ(fmt::format("{:5.1s}|", "xyz"), "x    |");
+}
+
+FORMAT_TEST(dynamic_width_and_precision) {
+  CHECK_EQ(fmt::format("[{:>{}}]", "a", 3), "[  a]");
+  CHECK_EQ(fmt::format("[{:.{}f}]", 3.14159, 2), "[3.14]");
+  CHECK_EQ(fmt::format("[{0:>{2}.{1}f}]", 2.5, 1, 6), "[   2.5]");
+  CHECK_EQ(fmt::format("[{:{}.{}}]", "abcdef", 5, 2), "[ab   ]");
+  CHECK_EQ(fmt::formatted_size("{:>{}}", "a", 10), 10U);
+  CHECK_THROWS(fmt::FormatError,
+               fmt::format(fmt::runtime("{:>{}}"), "a", -1));
+}
+
+FORMAT_TEST(specifier_errors) {
+  CHECK_THROWS(fmt::FormatError, fmt::FormatSpecifier{"5."});
+  CHECK_THROWS(fmt::FormatError, fmt::FormatSpecifier{"xx"});
+  CHECK_THROWS(fmt::FormatError, fmt::FormatSpecifier{"{<5"});
+  CHECK_THROWS(fmt::FormatError, fmt::format(fmt::runtime("{:5q}"), 1));
+}
+
+FORMAT_TEST(long_element_specifier) {
+  const std::vector<int> values{1, 2};
+  const std::string zeros(300, '0');
+  CHECK_EQ(fmt::format(fmt::runtime("{::>" + zeros + "3}"), values),
+           "[  1,   2]");
+  const fmt::ParsedFormat parsed{"{::>" + zeros + "3}"};
+  const fmt::ParsedFormat copy{parsed};
+  fmt::MemoryBuffer<> buf{};
+  copy.format(buf, fmt::make_format_args(values).view());
+  CHECK_EQ(buf.view(), "[  1,   2]");
+  const std::string too_long(fmt::FormatSpecifier::MaxNestedSize + 1, '0');
+  CHECK_THROWS(fmt::FormatError,
+               fmt::format(fmt::runtime("{::" + too_long + "}"), values));
+}
+
+FORMAT_TEST(automatic_and_manual_indices_do_not_mix) {
+  CHECK_THROWS(fmt::FormatError,
+               fmt::format(fmt::runtime("{} {1} {}"), 1, 2, 3));
+  CHECK_THROWS(fmt::FormatError, fmt::format(fmt::runtime("{0} {}"), 1, 2));
+  CHECK_THROWS(fmt::FormatError,
+               fmt::format(fmt::runtime("{:>{1}}"), "a", 3));
+  CHECK_THROWS(fmt::FormatError,
+               fmt::format(fmt::runtime("{0:>{}}"), "a", 3));
+  CHECK_EQ(fmt::format(fmt::runtime("{1} {0} {1}"), 1, 2), "2 1 2");
+  CHECK_EQ(fmt::format(fmt::runtime("{0:>{1}}"), "a", 3), "  a");
+}
@@ -0,0 +1,51 @@
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "format/format.hpp"
+#include "format/ranges.hpp"
+#include "format/wide.hpp"
+
+// Display-column widths, and strings and format strings of every encoding.
+
+FORMAT_TEST(widths_count_display_columns) {
+  CHECK_EQ(fmt::format("[{:>6}]", "日本"), "[  日本]");
+  CHECK_EQ(fmt::format("[{:.3}]", "日本"), "[日]");
+  CHECK_EQ(fmt::format("[{:*<4}]", "é"), "[é***]");
+  CHECK_EQ(fmt::formatted_size("[{:>6}]", "日本"), 10U);
+}
+
+FORMAT_TEST(other_encodings_are_written_as_utf8) {
+  CHECK_EQ(fmt::format("{} {}", u"wörld", L"wide"), "wörld wide");
+  CHECK_EQ(fmt::format("{}", U"😀"), "😀");
+  CHECK_EQ(fmt::format("[{:>3}]", u"日"), "[ 日]");
+  CHECK_EQ(fmt::to_utf8(u"a\xD800"), "a\xEF\xBF\xBD");
+}
+
+FORMAT_TEST(wide_output) {
+  CHECK(fmt::format_utf16("{} = {}", "x", 1) == u"x = 1");
+  CHECK(fmt::format_wide("{}日", "é") == L"é日");
+  CHECK(fmt::to_utf16("😀") == u"😀");
+}
+
+FORMAT_TEST(wide_output_across_chunks) {
+  // Longer than the conversion chunk, with sequences of every length
+  // straddling its boundaries.
+  std::string text{};
+  for (int i = 0; i < 200; ++i) {
+    text += "aé日😀";
+  }
+  CHECK(fmt::format_utf16("{}", text) == fmt::to_utf16(text));
+  CHECK(fmt::format_wide("-{}-", text) == fmt::to_wide("-" + text + "-"));
+  CHECK(fmt::format_utf16("{}", "\xE6\x97") == u"\xFFFD\xFFFD");
+}
+
+FORMAT_TEST(format_strings_of_other_units) {
+  CHECK(fmt::format(L"{} = {:>4}", L"x", 42) == L"x =   42");
+  CHECK(fmt::format(u"{}日{}", "é", u"😀") == u"é日😀");
+  CHECK(fmt::format(U"[{:*^5}]", U"日") == U"[*日**]");
+  CHECK(fmt::format(u8"{1}-{0:#x}", 255, u8"ü") == u8"ü-0xff");
+  CHECK(fmt::format(L"{:{}}|{::x}", 7, 3, std::vector<int>{10, 11}) ==
+        L"  7|[a, b]");
+  CHECK(fmt::format(L"no fields") == L"no fields");
+}